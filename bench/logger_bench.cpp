@@ -0,0 +1,547 @@
+// logger-bench: throughput and per-call latency sweeps for CoLog.
+//
+// Every combination of the swept knobs is run once; each producer thread
+// times every log() call with steady_clock and records it in a
+// LatencyHistogram. Results go to a JSON or CSV file, with a one-line
+// summary per run on stderr.
+//
+//   logger-bench --threads 1,4,8 --queue-bytes 64k,1m --msg-size 32,256
+//                --sink null,file --mode sync,async --format csv
+//
+// With --loggers N each of N loggers gets its own sink (file sinks write
+// to <file>.<i>) and thread t logs to logger t % N; combine with
+// --workers to measure async worker scaling across sinks.
+
+#include "colog/colog.h"
+#include "histogram.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using CoLog::Bench::LatencyHistogram;
+
+/**
+ * @brief Sweep definition parsed from the command line.
+ */
+struct Options {
+    std::vector<int> threads{1, 4};
+    std::vector<std::size_t> queue_bytes{64 * 1024, 1 << 20};
+    std::vector<std::size_t> msg_sizes{32, 256};
+    std::vector<std::string> sinks{"null", "file"};
+    std::vector<std::string> modes{"sync", "async"};
+    std::vector<std::string> queue_modes{"shared"};
+    std::vector<std::size_t> workers{1};
+    std::vector<std::string> on_full{"spin-park"};
+    std::size_t loggers = 1;
+    std::size_t messages = 100000;  // Per thread
+    std::size_t warmup = 1000;      // Per thread, not recorded
+    std::string format = "json";
+    std::string output;
+    std::string file_path = "logger-bench.log";
+};
+
+/**
+ * @brief One point of the sweep.
+ */
+struct RunConfig {
+    int threads;
+    std::size_t queue_bytes;  // 0 for sync runs
+    std::size_t msg_size;
+    std::string sink;
+    std::string mode;
+    std::string queue_mode;   // Empty for sync runs
+    std::size_t workers;      // 0 for sync runs
+    std::string on_full;      // Overflow policy; empty for sync runs
+};
+
+struct RunResult {
+    RunConfig config;
+    std::uint64_t messages = 0;
+    double produce_seconds = 0;  // First call to last call returning
+    double drain_seconds = 0;    // Last call returning to backend drained
+    CoLog::AsyncCounters counters;  // Async runs only
+    LatencyHistogram latency;
+};
+
+// --- Argument parsing ---
+
+std::vector<std::string> split(const std::string& text) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, ',')) {
+        if (!part.empty()) {
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+// Accepts plain numbers and k/m/g suffixes: "4096", "64k", "1m"
+std::size_t parse_size(const std::string& text) {
+    std::size_t pos = 0;
+    unsigned long long value = std::stoull(text, &pos);
+    if (pos < text.size()) {
+        switch (text[pos]) {
+            case 'k': case 'K': value <<= 10; break;
+            case 'm': case 'M': value <<= 20; break;
+            case 'g': case 'G': value <<= 30; break;
+            default: throw std::invalid_argument("bad size: " + text);
+        }
+    }
+    return static_cast<std::size_t>(value);
+}
+
+template <typename T, typename Parse>
+std::vector<T> parse_list(const std::string& text, Parse parse) {
+    std::vector<T> values;
+    for (const auto& part : split(text)) {
+        values.push_back(parse(part));
+    }
+    if (values.empty()) {
+        throw std::invalid_argument("empty list");
+    }
+    return values;
+}
+
+void print_usage() {
+    std::cerr <<
+        "Usage: logger-bench [options]\n"
+        "  --threads LIST       Producer thread counts (default 1,4)\n"
+        "  --queue-bytes LIST   Async ring sizes, k/m suffixes allowed (default 64k,1m)\n"
+        "  --msg-size LIST      Payload bytes per message (default 32,256)\n"
+        "  --sink LIST          null,file,bfile,binary,lz4file,uring,mmap,console (default null,file)\n"
+        "  --mode LIST          sync,async (default sync,async)\n"
+        "  --queue-mode LIST    shared,per-thread (default shared)\n"
+        "  --workers LIST       Async backend worker threads (default 1)\n"
+        "  --loggers N          Loggers, each with its own sink (default 1)\n"
+        "  --messages N         Timed messages per thread (default 100000)\n"
+        "  --warmup N           Untimed messages per thread (default 1000)\n"
+        "  --on-full LIST       yield,park,spin-park,discard,overrun (default spin-park)\n"
+        "  --discard            Same as --on-full discard\n"
+        "  --format json|csv    Result format (default json)\n"
+        "  --output FILE        Result file (default logger-bench.<format>)\n"
+        "  --file PATH          Log file used by the file sink (default logger-bench.log)\n";
+}
+
+Options parse_options(int argc, char** argv) {
+    Options options;
+    auto to_int = [](const std::string& s) { return std::stoi(s); };
+    auto to_string = [](const std::string& s) { return s; };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            std::exit(0);
+        }
+        if (arg == "--discard") {
+            options.on_full = {"discard"};
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("missing value for " + arg);
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--threads") {
+            options.threads = parse_list<int>(value, to_int);
+        } else if (arg == "--queue-bytes") {
+            options.queue_bytes = parse_list<std::size_t>(value, parse_size);
+        } else if (arg == "--msg-size") {
+            options.msg_sizes = parse_list<std::size_t>(value, parse_size);
+        } else if (arg == "--sink") {
+            options.sinks = parse_list<std::string>(value, to_string);
+        } else if (arg == "--mode") {
+            options.modes = parse_list<std::string>(value, to_string);
+        } else if (arg == "--queue-mode") {
+            options.queue_modes = parse_list<std::string>(value, to_string);
+        } else if (arg == "--workers") {
+            options.workers = parse_list<std::size_t>(value, parse_size);
+        } else if (arg == "--on-full") {
+            options.on_full = parse_list<std::string>(value, to_string);
+        } else if (arg == "--loggers") {
+            options.loggers = std::max<std::size_t>(1, parse_size(value));
+        } else if (arg == "--messages") {
+            options.messages = parse_size(value);
+        } else if (arg == "--warmup") {
+            options.warmup = parse_size(value);
+        } else if (arg == "--format") {
+            options.format = value;
+        } else if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--file") {
+            options.file_path = value;
+        } else {
+            throw std::invalid_argument("unknown option " + arg);
+        }
+    }
+
+    if (options.format != "json" && options.format != "csv") {
+        throw std::invalid_argument("--format must be json or csv");
+    }
+    if (options.output.empty()) {
+        options.output = "logger-bench." + options.format;
+    }
+    return options;
+}
+
+std::vector<RunConfig> expand(const Options& options) {
+    std::vector<RunConfig> runs;
+    for (const auto& mode : options.modes) {
+        if (mode != "sync" && mode != "async") {
+            throw std::invalid_argument("unknown mode " + mode);
+        }
+        bool async = mode == "async";
+        std::vector<std::size_t> queues = async ? options.queue_bytes
+                                                : std::vector<std::size_t>{0};
+        std::vector<std::string> queue_modes = async ? options.queue_modes
+                                                     : std::vector<std::string>{""};
+        std::vector<std::size_t> workers = async ? options.workers
+                                                 : std::vector<std::size_t>{0};
+        std::vector<std::string> on_full = async ? options.on_full
+                                                 : std::vector<std::string>{""};
+        for (const auto& sink : options.sinks) {
+            for (int threads : options.threads) {
+                for (std::size_t msg_size : options.msg_sizes) {
+                    for (std::size_t queue : queues) {
+                        for (const auto& queue_mode : queue_modes) {
+                            for (std::size_t worker_count : workers) {
+                                for (const auto& policy : on_full) {
+                                    runs.push_back({threads, queue, msg_size, sink, mode,
+                                                    queue_mode, worker_count, policy});
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return runs;
+}
+
+// --- Running ---
+
+CoLog::OverflowPolicy parse_overflow_policy(const std::string& name) {
+    if (name == "yield") {
+        return CoLog::OverflowPolicy::Yield;
+    }
+    if (name == "park") {
+        return CoLog::OverflowPolicy::Park;
+    }
+    if (name == "spin-park") {
+        return CoLog::OverflowPolicy::SpinThenPark;
+    }
+    if (name == "discard") {
+        return CoLog::OverflowPolicy::Discard;
+    }
+    if (name == "overrun") {
+        return CoLog::OverflowPolicy::Overrun;
+    }
+    throw std::invalid_argument("unknown overflow policy " + name);
+}
+
+CoLog::SinkPtr make_sink(const std::string& sink, const std::string& path) {
+    if (sink == "null") {
+        return std::make_shared<CoLog::NullSink>();
+    }
+    if (sink == "file") {
+        std::filesystem::remove(path);
+        return std::make_shared<CoLog::FileSink>(path, false);
+    }
+    if (sink == "bfile") {
+        std::filesystem::remove(path);
+        return std::make_shared<CoLog::BufferedFileSink>(path, false);
+    }
+    if (sink == "binary") {
+        std::filesystem::remove(path);
+        return std::make_shared<CoLog::BinaryFileSink>(path, false);
+    }
+    if (sink == "lz4file") {
+        std::filesystem::remove(path);
+        return std::make_shared<CoLog::CompressedFileSink>(path, false);
+    }
+#ifndef _WIN32
+    if (sink == "uring") {
+        std::filesystem::remove(path);
+        return std::make_shared<CoLog::UringFileSink>(path, false);
+    }
+    if (sink == "mmap") {
+        std::filesystem::remove(path);
+        return std::make_shared<CoLog::MmapFileSink>(path, false);
+    }
+#endif
+    if (sink == "console") {
+        return std::make_shared<CoLog::ConsoleSink>();
+    }
+    throw std::invalid_argument("unknown sink " + sink);
+}
+
+// Log file of logger @p index; plain file_path when there is one logger
+std::string sink_path(const Options& options, std::size_t index) {
+    return options.loggers > 1 ? options.file_path + "." + std::to_string(index)
+                               : options.file_path;
+}
+
+/**
+ * @brief Run the producer threads against @p loggers and collect latencies.
+ *
+ * Thread t logs to loggers[t % loggers.size()].
+ */
+template <typename LoggerT>
+void produce(const std::vector<std::unique_ptr<LoggerT>>& loggers, const RunConfig& config,
+             const Options& options, RunResult& result) {
+    const std::string payload(config.msg_size, 'x');
+    std::vector<LatencyHistogram> histograms(static_cast<std::size_t>(config.threads));
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < config.threads; ++t) {
+        workers.emplace_back([&, t] {
+            LoggerT& logger = *loggers[static_cast<std::size_t>(t) % loggers.size()];
+            std::string_view message = payload;
+            for (std::size_t i = 0; i < options.warmup; ++i) {
+                logger.info("{} {}", i, message);
+            }
+
+            LatencyHistogram& histogram = histograms[static_cast<std::size_t>(t)];
+            ready.fetch_add(1, std::memory_order_acq_rel);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+
+            for (std::size_t i = 0; i < options.messages; ++i) {
+                auto before = Clock::now();
+                logger.info("{} {}", i, message);
+                auto after = Clock::now();
+                histogram.record(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count()));
+            }
+        });
+    }
+
+    while (ready.load(std::memory_order_acquire) < config.threads) {
+        std::this_thread::yield();
+    }
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto produced = Clock::now();
+
+    for (const auto& logger : loggers) {
+        logger->flush();
+    }
+    if constexpr (std::is_same_v<LoggerT, CoLog::AsyncLogger>) {
+        loggers.front()->flush_wait(std::chrono::seconds(60));  // Waits for every worker
+    }
+    auto drained = Clock::now();
+
+    for (const auto& histogram : histograms) {
+        result.latency.merge(histogram);
+    }
+    result.messages = options.messages * static_cast<std::uint64_t>(config.threads);
+    result.produce_seconds = std::chrono::duration<double>(produced - start).count();
+    result.drain_seconds = std::chrono::duration<double>(drained - produced).count();
+}
+
+RunResult run(const RunConfig& config, const Options& options) {
+    RunResult result;
+    result.config = config;
+
+    // One logger per sink, named bench.<i>
+    auto make_loggers = [&](auto tag) {
+        using LoggerT = typename decltype(tag)::type;
+        std::vector<std::unique_ptr<LoggerT>> loggers;
+        for (std::size_t i = 0; i < options.loggers; ++i) {
+            CoLog::SinkPtr sink = make_sink(config.sink, sink_path(options, i));
+            auto logger = std::make_unique<LoggerT>("bench." + std::to_string(i));
+            logger->add_sink(std::move(sink));
+            loggers.push_back(std::move(logger));
+        }
+        return loggers;
+    };
+
+    if (config.mode == "sync") {
+        produce(make_loggers(std::type_identity<CoLog::Logger>{}), config, options, result);
+    } else {
+        CoLog::AsyncConfig async_config;
+        async_config.queue_bytes = config.queue_bytes;
+        async_config.overflow_policy = parse_overflow_policy(config.on_full);
+        async_config.worker_count = config.workers;
+        if (config.queue_mode == "per-thread") {
+            async_config.queue_mode = CoLog::QueueMode::PerThread;
+        } else if (config.queue_mode != "shared") {
+            throw std::invalid_argument("unknown queue mode " + config.queue_mode);
+        }
+        CoLog::init_async(async_config);
+        produce(make_loggers(std::type_identity<CoLog::AsyncLogger>{}), config, options, result);
+        result.counters = CoLog::AsyncBackend::instance().counters();
+        CoLog::shutdown_async();
+    }
+
+    if (config.sink != "null" && config.sink != "console") {
+        for (std::size_t i = 0; i < options.loggers; ++i) {
+            std::filesystem::remove(sink_path(options, i));
+        }
+    }
+    return result;
+}
+
+// --- Reporting ---
+
+double throughput(const RunResult& result) {
+    return result.produce_seconds > 0 ? result.messages / result.produce_seconds : 0.0;
+}
+
+std::string compiler_name() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_VER);
+#else
+    return "unknown";
+#endif
+}
+
+std::string os_name() {
+#if defined(__linux__)
+    return "linux";
+#elif defined(__APPLE__)
+    return "macos";
+#elif defined(_WIN32)
+    return "windows";
+#else
+    return "unknown";
+#endif
+}
+
+void write_json(std::ostream& out, const Options& options, const std::vector<RunResult>& results) {
+    out << "{\n";
+    out << "  \"system\": {\"os\": \"" << os_name() << "\", \"compiler\": \"" << compiler_name()
+        << "\", \"hardware_threads\": " << std::thread::hardware_concurrency() << "},\n";
+    out << "  \"messages_per_thread\": " << options.messages << ",\n";
+    out << "  \"latency_unit\": \"ns\",\n";
+    out << "  \"runs\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const RunResult& r = results[i];
+        const LatencyHistogram& h = r.latency;
+        out << "    {\"mode\": \"" << r.config.mode << "\", \"sink\": \"" << r.config.sink
+            << "\", \"threads\": " << r.config.threads
+            << ", \"queue_bytes\": " << r.config.queue_bytes
+            << ", \"queue_mode\": \"" << r.config.queue_mode << "\""
+            << ", \"workers\": " << r.config.workers
+            << ", \"on_full\": \"" << r.config.on_full << "\""
+            << ", \"msg_size\": " << r.config.msg_size
+            << ", \"messages\": " << r.messages
+            << ", \"produce_seconds\": " << r.produce_seconds
+            << ", \"drain_seconds\": " << r.drain_seconds
+            << ", \"msgs_per_sec\": " << throughput(r)
+            << ", \"queue_full\": " << r.counters.queue_full
+            << ", \"parked\": " << r.counters.parked
+            << ", \"discarded\": " << r.counters.discarded
+            << ", \"overrun\": " << r.counters.overrun
+            << ", \"latency\": {\"min\": " << h.min() << ", \"mean\": " << h.mean()
+            << ", \"p50\": " << h.percentile(50) << ", \"p99\": " << h.percentile(99)
+            << ", \"p99_9\": " << h.percentile(99.9) << ", \"max\": " << h.max() << "}}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+void write_csv(std::ostream& out, const std::vector<RunResult>& results) {
+    out << "mode,sink,threads,queue_bytes,queue_mode,workers,on_full,msg_size,messages,"
+           "produce_seconds,drain_seconds,msgs_per_sec,queue_full,parked,discarded,overrun,"
+           "min_ns,mean_ns,p50_ns,p99_ns,p99_9_ns,max_ns\n";
+    for (const RunResult& r : results) {
+        const LatencyHistogram& h = r.latency;
+        out << r.config.mode << ',' << r.config.sink << ',' << r.config.threads << ','
+            << r.config.queue_bytes << ',' << r.config.queue_mode << ',' << r.config.workers
+            << ',' << r.config.on_full << ',' << r.config.msg_size
+            << ',' << r.messages << ',' << r.produce_seconds << ',' << r.drain_seconds << ','
+            << throughput(r) << ',' << r.counters.queue_full << ',' << r.counters.parked << ','
+            << r.counters.discarded << ',' << r.counters.overrun << ',' << h.min() << ',' << h.mean() << ',' << h.percentile(50)
+            << ',' << h.percentile(99) << ',' << h.percentile(99.9) << ',' << h.max() << '\n';
+    }
+}
+
+void print_summary(const RunResult& r) {
+    const LatencyHistogram& h = r.latency;
+    std::fprintf(stderr,
+                 "%-5s %-7s threads=%-3d queue=%-8zu %-10s workers=%-2zu %-9s msg=%-5zu "
+                 "%12.0f msg/s  p50=%lluns p99=%lluns p99.9=%lluns max=%lluns",
+                 r.config.mode.c_str(), r.config.sink.c_str(), r.config.threads,
+                 r.config.queue_bytes, r.config.queue_mode.c_str(), r.config.workers,
+                 r.config.on_full.c_str(), r.config.msg_size,
+                 throughput(r), static_cast<unsigned long long>(h.percentile(50)),
+                 static_cast<unsigned long long>(h.percentile(99)),
+                 static_cast<unsigned long long>(h.percentile(99.9)),
+                 static_cast<unsigned long long>(h.max()));
+    if (r.counters.queue_full > 0) {
+        std::fprintf(stderr, "  full=%llu parked=%llu discarded=%llu overrun=%llu",
+                     static_cast<unsigned long long>(r.counters.queue_full),
+                     static_cast<unsigned long long>(r.counters.parked),
+                     static_cast<unsigned long long>(r.counters.discarded),
+                     static_cast<unsigned long long>(r.counters.overrun));
+    }
+    std::fprintf(stderr, "\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    std::vector<RunConfig> runs;
+    try {
+        options = parse_options(argc, argv);
+        runs = expand(options);
+    } catch (const std::exception& e) {
+        std::cerr << "logger-bench: " << e.what() << "\n";
+        print_usage();
+        return 2;
+    }
+
+    std::vector<RunResult> results;
+    for (const RunConfig& config : runs) {
+        try {
+            results.push_back(run(config, options));
+            print_summary(results.back());
+        } catch (const std::exception& e) {
+            std::cerr << "logger-bench: run failed: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    std::ofstream out(options.output);
+    if (!out) {
+        std::cerr << "logger-bench: cannot open " << options.output << "\n";
+        return 1;
+    }
+    if (options.format == "json") {
+        write_json(out, options, results);
+    } else {
+        write_csv(out, results);
+    }
+    std::cerr << "Wrote " << results.size() << " runs to " << options.output << "\n";
+    return 0;
+}
@@ -1,9 +1,53 @@
 #include "async_backend.h"
 
 #include <algorithm>
+#include <cstring>
+#include <new>
+
+#include "../os.h"
 
 namespace CoLog {
 
+namespace {
+
+/**
+ * @brief The calling thread's registrations in PerThread mode.
+ *
+ * One ring per worker, created on first use. Marks the queues closed when
+ * the thread exits (or the backend restarts) so the workers can drop them.
+ */
+struct LocalProducer {
+    std::vector<std::shared_ptr<ProducerQueue>> queues;
+    std::uint64_t session = 0;
+
+    void close() {
+        for (const auto& queue : queues) {
+            if (queue) {
+                queue->closed.store(true, std::memory_order_release);
+            }
+        }
+        queues.clear();
+    }
+
+    ~LocalProducer() { close(); }
+};
+
+thread_local LocalProducer t_local_producer;
+
+// Set on backend worker threads, which must never wait for queue space
+thread_local bool t_backend_worker = false;
+
+// Set by ~AsyncBackend(); constant-initialized, so still readable by
+// statics destroyed after the singleton
+constinit std::atomic<bool> g_backend_destroyed{false};
+
+// True once a ring's read position has passed a write position snapshot
+bool position_reached(std::size_t position, std::size_t target) {
+    return static_cast<std::ptrdiff_t>(position - target) >= 0;
+}
+
+}  // namespace
+
 AsyncBackend& AsyncBackend::instance() {
     static AsyncBackend instance;
     return instance;
@@ -13,193 +57,1236 @@ AsyncBackend::~AsyncBackend() {
     if (running_.load(std::memory_order_acquire)) {
         stop();
     }
+    // Files closed since (sinks destroyed at the end of main) still get
+    // compressed before the compressor abandons its queue
+    compressor_.drain(kExitCompressionTimeout);
+    // Process exit: anything still retired can no longer be in use
+    retired_.clear();
+    g_backend_destroyed.store(true, std::memory_order_release);
+}
+
+void AsyncBackend::compress_closed_file(std::string path, Compression codec) noexcept {
+    if (codec == Compression::None || g_backend_destroyed.load(std::memory_order_acquire)) {
+        return;
+    }
+    try {
+        // The future is not needed: the source stays if compression fails
+        instance().compressor().submit(std::move(path), codec);
+    } catch (...) {
+        // Leave the file uncompressed
+    }
 }
 
 void AsyncBackend::start(const AsyncConfig& config) {
-    // Prevent double-start
+    // Prevent double-start. running_ is only published below, once the
+    // workers exist: producers read workers_ as soon as they see it.
     bool expected = false;
-    if (!running_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
-        return;  // Already running
+    if (!started_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        return;  // Already running, or another start() is under way
     }
 
     config_ = config;
+    if (config_.discard_on_full) {
+        config_.overflow_policy = OverflowPolicy::Discard;
+    }
+    config_.worker_count = std::clamp<std::size_t>(config_.worker_count, 1, kMaxWorkers);
     stop_requested_.store(false, std::memory_order_release);
-    flush_requested_.store(false, std::memory_order_release);
-    processed_generation_.store(0, std::memory_order_release);
+    session_.fetch_add(1, std::memory_order_acq_rel);
+    compressor_.configure(config_.compression_threads, config_.compression_bytes_per_second);
 
-    // Create the queue
-    queue_ = std::make_unique<LockFreeQueue<AsyncLogItem>>(config_.queue_size);
+    // Fresh workers; the previous run's are idle and their rings unused
+    workers_.clear();
+    for (std::size_t i = 0; i < config_.worker_count; ++i) {
+        auto worker = std::make_unique<Worker>(i);
+        // Create the ring; per-thread rings are created on first submit
+        if (config_.queue_mode == QueueMode::Shared) {
+            worker->queue = std::make_unique<SharedByteRing>(config_.queue_bytes);
+        }
+        workers_.push_back(std::move(worker));
+    }
+    worker_count_.store(workers_.size(), std::memory_order_release);
+    active_workers_.store(workers_.size(), std::memory_order_release);
+    running_.store(true, std::memory_order_release);
 
-    // Start the worker thread
-    worker_thread_ = std::thread(&AsyncBackend::worker_loop, this);
+    // Start the worker threads
+    for (auto& worker : workers_) {
+        worker->thread = std::thread(&AsyncBackend::worker_loop, this, std::ref(*worker));
+    }
 }
 
 void AsyncBackend::stop(std::chrono::milliseconds timeout) {
     // Signal stop
-    stop_requested_.store(true, std::memory_order_release);
+    stop_requested_.store(true, std::memory_order_seq_cst);
 
-    // Wake up the worker
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        cv_.notify_all();
+    // Wake up the workers, and any producers parked on a full ring
+    for (auto& worker : workers_) {
+        wake_worker(*worker);
+        worker->space_epoch.fetch_add(1, std::memory_order_release);
+        worker->space_epoch.notify_all();
     }
 
-    // Wait for the worker to finish (with timeout)
-    if (worker_thread_.joinable()) {
-        // Use a simple polling approach with timeout
-        auto start = std::chrono::steady_clock::now();
-        while (running_.load(std::memory_order_acquire)) {
-            if (std::chrono::steady_clock::now() - start > timeout) {
-                // Timeout - force detach (not ideal but prevents hanging)
-                break;
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    // Wait for the workers to finish (with timeout); each exiting worker
+    // wakes us
+    auto start = std::chrono::steady_clock::now();
+    std::uint32_t active;
+    while ((active = active_workers_.load(std::memory_order_acquire)) > 0) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed > timeout) {
+            // Timeout - stop waiting and join (not ideal but prevents hanging)
+            break;
         }
-        
-        if (worker_thread_.joinable()) {
-            worker_thread_.join();
+        futex_wait(active_workers_, active,
+                   std::chrono::ceil<std::chrono::microseconds>(timeout - elapsed));
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
         }
     }
 
     running_.store(false, std::memory_order_release);
-    queue_.reset();
+
+    // Producers check running_ under an EpochGuard; let those that saw it
+    // set leave the rings before they are torn down and, on a restart,
+    // before start() rebuilds workers_. No deadline: a pinned producer may
+    // still be writing into a ring. With stop_requested_ set they give up
+    // waiting for space, so this is short.
+    EpochManager& epochs = EpochManager::instance();
+    std::uint64_t epoch = epochs.advance();
+    while (!epochs.quiescent_since(epoch)) {
+        std::this_thread::yield();
+    }
+
+    // Anyone still waiting sees the backend stopped. Flush requests that
+    // came in after their worker exited have nothing left to wait for.
+    for (auto& worker : workers_) {
+        complete_flushes(*worker, true);
+        notify_waiters(*worker, true);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(producers_mutex_);
+        for (auto& worker : workers_) {
+            worker->queue.reset();
+            worker->producers.clear();
+            worker->local_producers.clear();
+            worker->producers_version.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    collect_retired(false);
+
+    // Finish compressing the files closed so far, within what is left of
+    // the timeout
+    auto left = timeout - std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::steady_clock::now() - start);
+    compressor_.drain(std::max(left, std::chrono::milliseconds{0}));
+
+    started_.store(false, std::memory_order_release);
+}
+
+const AsyncLoggerState* AsyncBackend::register_logger(AsyncLoggerState state) {
+    {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        std::erase_if(sink_shards_, [](const auto& entry) { return entry.second.sink.expired(); });
+
+        state.sink_shards.clear();
+        state.record_sinks.clear();
+        state.text_sinks = false;
+        for (const auto& sink : state.sinks) {
+            state.record_sinks.push_back(sink->writes_records());
+            state.text_sinks = state.text_sinks || !state.record_sinks.back();
+            auto [it, inserted] = sink_shards_.try_emplace(sink.get(), SinkShard{sink, next_shard_});
+            if (inserted) {
+                ++next_shard_;
+            }
+            state.sink_shards.push_back(it->second.shard);
+        }
+    }
+    return new AsyncLoggerState(std::move(state));
 }
 
-bool AsyncBackend::submit(AsyncLogItem item) {
-    if (!running_.load(std::memory_order_acquire) || !queue_) {
-        return false;
+void AsyncBackend::retire_logger(const AsyncLoggerState* state) {
+    if (state == nullptr) {
+        return;
     }
 
-    if (config_.discard_on_full) {
-        // Non-blocking: discard if full
-        return queue_->try_push(std::move(item));
-    } else {
-        // Blocking: spin until we can push (with backoff)
-        while (!queue_->try_push(std::move(item))) {
-            if (stop_requested_.load(std::memory_order_acquire)) {
-                return false;  // Give up if stopping
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        RetiredLogger retired;
+        retired.state.reset(state);
+        retired.epoch = EpochManager::instance().advance();
+        retired_.push_back(std::move(retired));
+        retired_count_.store(retired_.size(), std::memory_order_release);
+    }
+
+    // Without workers there are no queued records left to wait for
+    bool running;
+    {
+        // Keeps workers_ alive while we wake worker 0 (see stop())
+        EpochGuard guard;
+        running = running_.load(std::memory_order_acquire);
+        if (running && !workers_.empty()) {
+            // Worker 0 collects retired states; make it stop sleeping
+            // indefinitely so it retries until the state can go
+            notify_committed(*workers_[0]);
+        }
+    }
+    if (!running) {
+        collect_retired(false);
+    }
+}
+
+void AsyncBackend::collect_retired(bool in_worker) {
+    std::lock_guard<std::mutex> lock(retired_mutex_);
+    std::erase_if(retired_, [&](RetiredLogger& retired) {
+        if (!retired.fenced) {
+            if (!EpochManager::instance().quiescent_since(retired.epoch)) {
+                return false;  // A producer may still be submitting with it
+            }
+            if (!in_worker) {
+                return true;
             }
-            std::this_thread::yield();
+
+            // Every record naming the state is committed by now, in a ring
+            // some worker owns; snapshot all of them, including rings
+            // registered during the grace period
+            retired.fenced = true;
+            std::lock_guard<std::mutex> producers_lock(producers_mutex_);
+            for (const auto& worker : workers_) {
+                if (worker->queue) {
+                    retired.shared_positions.emplace_back(worker->queue.get(),
+                                                          worker->queue->write_position());
+                }
+                for (const auto& producer : worker->producers) {
+                    retired.positions.emplace_back(producer, producer->ring.write_position());
+                }
+            }
+        }
+
+        if (!in_worker) {
+            return true;
+        }
+        if (!retired.released) {
+            for (const auto& [ring, position] : retired.shared_positions) {
+                if (!position_reached(ring->read_position(), position)) {
+                    return false;
+                }
+            }
+            for (const auto& [producer, position] : retired.positions) {
+                if (!position_reached(producer->ring.read_position(), position)) {
+                    return false;
+                }
+            }
+            if (config_.overflow_policy != OverflowPolicy::Overrun) {
+                return true;
+            }
+            retired.released = true;
+            for (const auto& worker : workers_) {
+                retired.copy_sequences.push_back(
+                    worker->copy_sequence.load(std::memory_order_acquire));
+            }
+        }
+
+        // Overrun: every record naming the state has been copied out; wait
+        // for workers that were mid-batch to finish processing the copies
+        for (std::size_t i = 0; i < retired.copy_sequences.size(); ++i) {
+            std::uint64_t sequence = retired.copy_sequences[i];
+            if (sequence % 2 == 1 &&
+                workers_[i]->copy_sequence.load(std::memory_order_acquire) == sequence) {
+                return false;
+            }
+        }
+        return true;
+    });
+    retired_count_.store(retired_.size(), std::memory_order_release);
+}
+
+ProducerQueue* AsyncBackend::local_queue(Worker& worker) {
+    LocalProducer& local = t_local_producer;
+    std::uint64_t session = session_.load(std::memory_order_acquire);
+    if (local.session == session && worker.index < local.queues.size() &&
+        local.queues[worker.index]) {
+        return local.queues[worker.index].get();
+    }
+
+    if (local.session != session) {
+        // The backend was restarted: the old rings are gone
+        local.close();
+        local.session = session;
+    }
+
+    // First submit from this thread to this worker
+    auto queue = std::make_shared<ProducerQueue>(config_.queue_bytes);
+    {
+        std::lock_guard<std::mutex> lock(producers_mutex_);
+        worker.producers.push_back(queue);
+        worker.producers_version.fetch_add(1, std::memory_order_release);
+    }
+    wake(worker);
+
+    if (local.queues.size() <= worker.index) {
+        local.queues.resize(worker.index + 1);
+    }
+    local.queues[worker.index] = std::move(queue);
+    return local.queues[worker.index].get();
+}
+
+std::byte* AsyncBackend::try_reserve(Worker& worker, std::size_t size) {
+    if (config_.queue_mode == QueueMode::PerThread) {
+        return local_queue(worker)->ring.try_reserve(size);
+    }
+    return worker.queue ? worker.queue->try_reserve(size) : nullptr;
+}
+
+AsyncRecord* AsyncBackend::reserve_record(std::size_t worker_index,
+                                          const AsyncLoggerState* logger, LogLevel level,
+                                          std::uint32_t site, std::size_t args_size,
+                                          std::chrono::system_clock::time_point timestamp,
+                                          bool blocking) {
+    // Nothing new once stop() has begun, so the final drain can finish
+    // while producers keep logging
+    if (!running_.load(std::memory_order_acquire) ||
+        stop_requested_.load(std::memory_order_relaxed) || worker_index >= workers_.size()) {
+        return nullptr;
+    }
+    Worker& worker = *workers_[worker_index];
+    std::size_t size = sizeof(AsyncRecord) + args_size;
+
+    std::byte* payload = try_reserve(worker, size);
+    if (payload == nullptr) {
+        worker.queue_full.fetch_add(1, std::memory_order_relaxed);
+        // Make sure the worker is awake to free space, rather than waiting
+        // out its flush interval
+        wake(worker);
+        if (!blocking) {
+            return nullptr;  // The caller waits its own way
+        }
+        payload = reserve_full(worker, size);
+        if (payload == nullptr) {
+            worker.discarded.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+
+    return new (payload) AsyncRecord{logger, timestamp, current_thread_id(), site,
+                                     static_cast<std::uint32_t>(args_size), level};
+}
+
+std::byte* AsyncBackend::reserve_full(Worker& worker, std::size_t size) {
+    OverflowPolicy policy = config_.overflow_policy;
+    if (policy == OverflowPolicy::Discard || t_backend_worker) {
+        return nullptr;
+    }
+    std::size_t capacity = config_.queue_mode == QueueMode::PerThread
+                               ? local_queue(worker)->ring.capacity()
+                               : worker.queue->capacity();
+    if (detail::record_total_size(size) > capacity / 2) {
+        return nullptr;  // Would never fit, however long we wait
+    }
+
+    std::size_t spins = 0;
+    while (!stop_requested_.load(std::memory_order_acquire)) {
+        std::byte* payload = nullptr;
+        switch (policy) {
+            case OverflowPolicy::Overrun:
+                if (!drop_oldest(worker)) {
+                    std::this_thread::yield();  // Oldest not committed yet
+                }
+                payload = try_reserve(worker, size);
+                break;
+            case OverflowPolicy::Yield:
+                std::this_thread::yield();
+                payload = try_reserve(worker, size);
+                break;
+            case OverflowPolicy::SpinThenPark:
+                if (spins < config_.spin_before_park) {
+                    ++spins;
+                    cpu_relax();
+                    payload = try_reserve(worker, size);
+                    break;
+                }
+                [[fallthrough]];
+            default:
+                payload = park(worker, size);
+                break;
+        }
+        if (payload != nullptr) {
+            return payload;
         }
+    }
+    return nullptr;  // Give up if stopping
+}
+
+std::byte* AsyncBackend::park(Worker& worker, std::size_t size) {
+    std::uint32_t epoch = worker.space_epoch.load(std::memory_order_acquire);
+    worker.parked_producers.fetch_add(1, std::memory_order_seq_cst);
+    // Pairs with the fence in notify_space(): either the worker sees us
+    // parked, or the retry sees the space it released
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    std::byte* payload = try_reserve(worker, size);
+    if (payload == nullptr && !stop_requested_.load(std::memory_order_seq_cst)) {
+        worker.parked.fetch_add(1, std::memory_order_relaxed);
+        worker.space_epoch.wait(epoch, std::memory_order_acquire);
+    }
+    worker.parked_producers.fetch_sub(1, std::memory_order_relaxed);
+    return payload;
+}
+
+bool AsyncBackend::drop_oldest(Worker& worker) {
+    auto drop = [](auto& ring, std::mutex& consumer_mutex) {
+        std::lock_guard<std::mutex> lock(consumer_mutex);
+        if (ring.peek().empty()) {
+            return false;
+        }
+        ring.pop();
+        ring.release();
         return true;
+    };
+
+    bool dropped = false;
+    if (config_.queue_mode == QueueMode::PerThread) {
+        ProducerQueue* producer = local_queue(worker);
+        dropped = drop(producer->ring, producer->consumer_mutex);
+    } else if (worker.queue) {
+        dropped = drop(*worker.queue, worker.consumer_mutex);
+    }
+    if (dropped) {
+        worker.overrun.fetch_add(1, std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+void AsyncBackend::notify_space(Worker& worker) {
+    // Pairs with the fence in park()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (worker.parked_producers.load(std::memory_order_relaxed) != 0) {
+        worker.space_epoch.fetch_add(1, std::memory_order_release);
+        worker.space_epoch.notify_all();
+    }
+}
+
+bool AsyncBackend::submit(const AsyncLoggerState* logger, LogLevel level,
+                          std::string_view message, std::source_location loc) {
+    std::uint32_t site = SiteRegistry::instance().intern(nullptr, loc);
+    auto timestamp = std::chrono::system_clock::now();
+    bool submitted = true;
+    for (std::uint64_t routes = route_mask(*logger); routes != 0; routes &= routes - 1) {
+        auto worker = static_cast<std::size_t>(std::countr_zero(routes));
+        AsyncRecord* record =
+            reserve_record(worker, logger, level, site, message.size(), timestamp, true);
+        if (record == nullptr) {
+            submitted = false;
+            continue;
+        }
+        std::memcpy(record->args(), message.data(), message.size());
+        commit_record(reinterpret_cast<std::byte*>(record));
+        notify_committed(*workers_[worker]);
+    }
+    return submitted;
+}
+
+void AsyncBackend::wake(Worker& worker) {
+    worker.flush_requested.store(true, std::memory_order_release);
+    notify_committed(worker);
+}
+
+void AsyncBackend::wake_worker(Worker& worker) {
+    worker.wake_word.fetch_add(1, std::memory_order_release);
+    futex_wake_all(worker.wake_word);
+}
+
+void AsyncBackend::wait_for_work(Worker& worker, std::chrono::microseconds timeout) {
+    auto spin_until = std::chrono::steady_clock::now() + std::min(timeout, kIdleSpin);
+    while (std::chrono::steady_clock::now() < spin_until) {
+        if (has_work(worker)) {
+            return;
+        }
+        std::this_thread::yield();
     }
+
+    std::uint32_t word = worker.wake_word.load(std::memory_order_acquire);
+    worker.sleeping.store(true, std::memory_order_relaxed);
+    // Pairs with the fence in notify_committed(): either the producer sees
+    // us asleep, or we see its record (or flush request) below
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!has_work(worker)) {
+        futex_wait(worker.wake_word, word, timeout);
+    }
+    worker.sleeping.store(false, std::memory_order_relaxed);
+}
+
+bool AsyncBackend::has_work(const Worker& worker) const {
+    // While throttled, queued records must wait for the backlogs
+    return stop_requested_.load(std::memory_order_acquire) ||
+           (!worker.throttled &&
+            (worker.flush_requested.load(std::memory_order_acquire) ||
+             worker.local_producers_version !=
+                 worker.producers_version.load(std::memory_order_acquire) ||
+             has_pending(worker)));
 }
 
 void AsyncBackend::flush() {
+    EpochGuard guard;
     if (!running_.load(std::memory_order_acquire)) {
         return;
     }
 
-    flush_requested_.store(true, std::memory_order_release);
-    
-    std::lock_guard<std::mutex> lock(mutex_);
-    cv_.notify_one();
+    for (auto& worker : workers_) {
+        wake(*worker);
+    }
 }
 
-bool AsyncBackend::wait_for_drain(std::chrono::milliseconds timeout) {
+void AsyncBackend::notify_waiters(Worker& worker, bool now) {
+    // Pairs with the fence in add_waiter()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (worker.waiter_count.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+
+    std::vector<std::coroutine_handle<>> waiters;
+    {
+        std::lock_guard<std::mutex> lock(worker.waiters_mutex);
+        waiters.swap(worker.waiters);
+        worker.waiter_count.store(0, std::memory_order_relaxed);
+    }
+    for (std::coroutine_handle<> handle : waiters) {
+        if (config_.resume_waiter) {
+            try {
+                config_.resume_waiter(handle);
+            } catch (...) {
+                handle.resume();  // Never strand a waiter
+            }
+        } else if (now) {
+            handle.resume();
+        } else {
+            worker.resumable.push_back(handle);
+        }
+    }
+}
+
+void AsyncBackend::resume_waiters(Worker& worker) {
+    std::vector<std::coroutine_handle<>> resumable;
+    resumable.swap(worker.resumable);
+    for (std::coroutine_handle<> handle : resumable) {
+        handle.resume();
+    }
+}
+
+std::shared_ptr<FlushBarrier> AsyncBackend::request_flush(const AsyncLoggerState* logger) {
+    EpochGuard guard;
     if (!running_.load(std::memory_order_acquire)) {
-        return true;
+        return nullptr;
     }
 
-    // Record the current generation and request a flush
-    auto target = processed_generation_.load(std::memory_order_acquire) + 1;
-    flush();
+    auto barrier = std::make_shared<FlushBarrier>();
+    std::uint64_t routes = ~std::uint64_t{0};
+    if (logger != nullptr) {
+        barrier->sinks = logger->sinks;
+        barrier->all_sinks = false;
+        routes = route_mask(*logger);
+    }
+    std::size_t count = std::min(workers_.size(), kMaxWorkers);
+    if (count < kMaxWorkers) {
+        routes &= (std::uint64_t{1} << count) - 1;
+    }
+    barrier->remaining.store(routes, std::memory_order_relaxed);
+    if (routes == 0) {
+        barrier->done.store(1, std::memory_order_release);
+        return barrier;
+    }
 
+    // Everything committed before now lies below these positions
+    std::vector<FlushRequest> requests(count);
+    {
+        std::lock_guard<std::mutex> lock(producers_mutex_);
+        for (std::uint64_t rest = routes; rest != 0; rest &= rest - 1) {
+            auto index = static_cast<std::size_t>(std::countr_zero(rest));
+            Worker& worker = *workers_[index];
+            FlushRequest& request = requests[index];
+            request.barrier = barrier;
+            if (worker.queue) {
+                request.shared_position = worker.queue->write_position();
+            }
+            for (const auto& producer : worker.producers) {
+                request.positions.emplace_back(producer, producer->ring.write_position());
+            }
+        }
+    }
+
+    for (std::uint64_t rest = routes; rest != 0; rest &= rest - 1) {
+        auto index = static_cast<std::size_t>(std::countr_zero(rest));
+        Worker& worker = *workers_[index];
+        bool queued = false;
+        {
+            std::lock_guard<std::mutex> lock(worker.flush_mutex);
+            // Checked under the lock: stop() sweeps the requests after
+            // clearing running_
+            if (running_.load(std::memory_order_acquire)) {
+                worker.flush_requests.push_back(std::move(requests[index]));
+                worker.flush_request_count.fetch_add(1, std::memory_order_release);
+                queued = true;
+            }
+        }
+        if (queued) {
+            wake(worker);
+        } else {
+            finish_flush(index, *barrier);  // Stopped meanwhile
+        }
+    }
+    return barrier;
+}
+
+bool AsyncBackend::wait_for_flush(const FlushBarrier& barrier,
+                                  std::chrono::milliseconds timeout) {
+    if (t_backend_worker) {
+        // A worker (e.g. running a resumed coroutine) cannot wait for itself
+        return barrier.done.load(std::memory_order_acquire) != 0;
+    }
+
+    // The last worker to complete the barrier wakes us
     auto start = std::chrono::steady_clock::now();
-    while (processed_generation_.load(std::memory_order_acquire) < target) {
-        if (std::chrono::steady_clock::now() - start > timeout) {
+    while (barrier.done.load(std::memory_order_acquire) == 0) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed > timeout) {
             return false;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        futex_wait(barrier.done, 0,
+                   std::chrono::ceil<std::chrono::microseconds>(timeout - elapsed));
     }
     return true;
 }
 
-std::size_t AsyncBackend::queue_size() const {
-    if (!queue_) return 0;
-    return queue_->size_approx();
+bool AsyncBackend::wait_for_drain(std::chrono::milliseconds timeout) {
+    std::shared_ptr<FlushBarrier> barrier = request_flush();
+    return barrier == nullptr || wait_for_flush(*barrier, timeout);
 }
 
-void AsyncBackend::worker_loop() {
+void AsyncBackend::complete_flushes(Worker& worker, bool all) {
+    if (worker.flush_request_count.load(std::memory_order_acquire) != 0) {
+        std::lock_guard<std::mutex> lock(worker.flush_mutex);
+        std::move(worker.flush_requests.begin(), worker.flush_requests.end(),
+                  std::back_inserter(worker.flushes));
+        worker.flush_requests.clear();
+        worker.flush_request_count.store(0, std::memory_order_relaxed);
+    }
+    if (worker.flushes.empty()) {
+        return;
+    }
+
+    // Only this thread consumes the rings and writes the backlogs, so
+    // positions reached here are fully processed
+    bool completed = false;
+    std::erase_if(worker.flushes, [&](FlushRequest& request) {
+        if (!all && !request.reached) {
+            if (worker.queue &&
+                !position_reached(worker.queue->read_position(), request.shared_position)) {
+                return false;
+            }
+            for (const auto& [producer, position] : request.positions) {
+                if (!position_reached(producer->ring.read_position(), position)) {
+                    return false;
+                }
+            }
+            request.reached = true;
+            for (const auto& [sink, stream] : worker.streams) {
+                if (stream->sink && stream->written < stream->appended) {
+                    request.backlogs.emplace_back(stream.get(), stream->appended);
+                }
+            }
+        }
+        if (!all) {
+            for (const auto& [stream, appended] : request.backlogs) {
+                if (stream->written < appended) {
+                    return false;
+                }
+            }
+        }
+
+        flush_sinks(worker, *request.barrier);
+        finish_flush(worker.index, *request.barrier);
+        completed = true;
+        return true;
+    });
+    if (completed) {
+        notify_waiters(worker, all);
+    }
+}
+
+void AsyncBackend::flush_sinks(Worker& worker, const FlushBarrier& barrier) {
+    std::erase_if(worker.unflushed_sinks, [&](const SinkPtr& sink) {
+        if (!barrier.all_sinks &&
+            std::find(barrier.sinks.begin(), barrier.sinks.end(), sink) == barrier.sinks.end()) {
+            return false;
+        }
+        try {
+            sink->flush();
+        } catch (...) {
+            // Same policy as process_record()
+        }
+        return true;
+    });
+}
+
+void AsyncBackend::finish_flush(std::size_t worker, FlushBarrier& barrier) {
+    std::uint64_t bit = std::uint64_t{1} << worker;
+    if (barrier.remaining.fetch_and(~bit, std::memory_order_acq_rel) == bit) {
+        barrier.done.store(1, std::memory_order_release);
+        futex_wake_all(barrier.done);
+    }
+}
+
+AsyncCounters AsyncBackend::counters() const {
+    AsyncCounters counters;
+    EpochGuard guard;
+    if (!running_.load(std::memory_order_acquire)) {
+        return counters;
+    }
+    for (const auto& worker : workers_) {
+        counters.queue_full += worker->queue_full.load(std::memory_order_relaxed);
+        counters.parked += worker->parked.load(std::memory_order_relaxed);
+        counters.discarded += worker->discarded.load(std::memory_order_relaxed);
+        counters.overrun += worker->overrun.load(std::memory_order_relaxed);
+    }
+    return counters;
+}
+
+std::size_t AsyncBackend::pending_bytes() const {
+    EpochGuard guard;
+    if (!running_.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(producers_mutex_);
+    std::size_t total = 0;
+    for (const auto& worker : workers_) {
+        if (worker->queue) {
+            total += worker->queue->size_approx();
+        }
+        for (const auto& producer : worker->producers) {
+            total += producer->ring.size_approx();
+        }
+    }
+    return total;
+}
+
+void AsyncBackend::refresh_producers(Worker& worker) {
+    if (worker.local_producers_version ==
+        worker.producers_version.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(producers_mutex_);
+
+    // Forget rings whose thread has exited and that have been drained
+    std::erase_if(worker.producers, [](const std::shared_ptr<ProducerQueue>& producer) {
+        return producer->closed.load(std::memory_order_acquire) && producer->ring.empty();
+    });
+
+    worker.local_producers = worker.producers;
+    worker.local_producers_version = worker.producers_version.load(std::memory_order_acquire);
+    worker.next_producer = 0;
+}
+
+template <typename Ring>
+bool AsyncBackend::ring_has_pending(const Ring& ring, std::mutex& consumer_mutex) const {
+    if (config_.overflow_policy != OverflowPolicy::Overrun) {
+        return ring.has_pending();
+    }
+    // Producers move the read cursor when they drop records
+    std::lock_guard<std::mutex> lock(consumer_mutex);
+    return ring.has_pending();
+}
+
+bool AsyncBackend::has_pending(const Worker& worker) const {
+    if (worker.queue) {
+        return ring_has_pending(*worker.queue, worker.consumer_mutex);
+    }
+    for (const auto& producer : worker.local_producers) {
+        if (ring_has_pending(producer->ring, producer->consumer_mutex)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AsyncBackend::worker_loop(Worker& worker) {
+    t_backend_worker = true;
+    worker.dispatcher = dispatch(worker);
+    worker.scheduler.schedule(worker.dispatcher.handle());
+
     while (!stop_requested_.load(std::memory_order_acquire)) {
+        // Run whatever is ready; the dispatcher yields after every batch
+        if (worker.scheduler.run_ready()) {
+            continue;
+        }
+        if (!worker.resumable.empty()) {
+            resume_waiters(worker);
+            continue;
+        }
+
+        // Nothing ready: sleep until a producer commits to an empty queue
+        // or requests a flush. Only time out to retry the sinks that would
+        // have blocked, or to collect retired logger states.
+        std::chrono::microseconds timeout = std::chrono::microseconds::max();
+        if (worker.scheduler.has_polling()) {
+            timeout = kSinkPollInterval;
+        } else if (worker.index == 0 && retired_count_.load(std::memory_order_acquire) > 0) {
+            timeout = config_.flush_interval;
+        }
+        // Or to end a batch for sinks holding data until it is old enough
+        timeout = std::min(timeout, run_sink_deadlines(worker));
+        wait_for_work(worker, timeout);
+        worker.scheduler.wake_polling();
+        worker.idle.set();
+    }
+
+    // Drain remaining items before exit
+    drain_queue(worker);
+    active_workers_.fetch_sub(1, std::memory_order_acq_rel);
+    futex_wake_all(active_workers_);
+}
+
+detail::Task AsyncBackend::dispatch(Worker& worker) {
+    for (;;) {
+        // Stop dequeuing while the backlogs hold a queue's worth of data;
+        // the rings then push back on producers as usual
+        worker.throttled = worker.backlog_bytes >= config_.queue_bytes;
+        if (worker.throttled) {
+            co_await worker.scheduler.poll();
+            continue;
+        }
+
         // Process a batch
-        std::size_t processed = process_batch();
+        std::size_t processed = process_batch(worker);
+
+        // One worker is enough to reclaim retired states; it checks every
+        // worker's rings
+        if (worker.index == 0 && retired_count_.load(std::memory_order_acquire) > 0) {
+            collect_retired(true);
+        }
 
-        // If we processed something, continue immediately
+        // If we processed something, continue once the sink streams have run
         if (processed > 0) {
-            processed_generation_.fetch_add(1, std::memory_order_release);
+            notify_waiters(worker, false);  // Queue space was freed
+            complete_flushes(worker, false);
+            co_await worker.scheduler.yield();
             continue;
         }
 
-        // Wait for new items or flush request
-        std::unique_lock<std::mutex> lock(mutex_);
-        cv_.wait_for(lock, config_.flush_interval, [this] {
-            return stop_requested_.load(std::memory_order_acquire) ||
-                   flush_requested_.load(std::memory_order_acquire) ||
-                   (queue_ && !queue_->empty());
-        });
+        co_await worker.idle;
 
-        flush_requested_.store(false, std::memory_order_release);
+        // A flush request that finds nothing queued completes right here;
+        // with a backlog, finish_backlog() completes it instead
+        if (worker.flush_requested.exchange(false, std::memory_order_acq_rel)) {
+            complete_flushes(worker, false);
+        }
     }
+}
 
-    // Drain remaining items before exit
-    drain_queue();
-    running_.store(false, std::memory_order_release);
+detail::Task AsyncBackend::sink_stream(Worker& worker, SinkStream& stream) {
+    for (;;) {
+        co_await stream.pending;
+
+        while (stream.next < stream.lengths.size()) {
+            bool blocked = false;
+            try {
+                blocked = stream.sink->would_block(stream.lengths[stream.next]);
+            } catch (...) {
+                // Let write() report the failure
+            }
+            if (blocked) {
+                co_await worker.scheduler.poll();
+                continue;
+            }
+            write_next(worker, stream);
+        }
+        finish_backlog(worker, stream);
+    }
 }
 
-std::size_t AsyncBackend::process_batch() {
-    if (!queue_) return 0;
+bool AsyncBackend::defer_write(Worker& worker, const SinkPtr& sink, std::string_view message) {
+    SinkStream* stream = nullptr;
+    if (worker.backlogged_streams > 0) {
+        auto it = worker.streams.find(sink.get());
+        if (it != worker.streams.end() && it->second->sink) {
+            stream = it->second.get();  // Already backlogged: keep the order
+        }
+    }
+
+    if (stream == nullptr) {
+        if (!sink->would_block(message.size())) {
+            return false;
+        }
+        std::unique_ptr<SinkStream>& slot = worker.streams[sink.get()];
+        if (!slot) {
+            slot = std::make_unique<SinkStream>(worker.scheduler);
+            slot->task = sink_stream(worker, *slot);
+            worker.scheduler.schedule(slot->task.handle());
+        }
+        stream = slot.get();
+        stream->sink = sink;
+        ++worker.backlogged_streams;
+        stream->pending.set();
+    }
 
+    stream->data.append(message);
+    stream->lengths.push_back(static_cast<std::uint32_t>(message.size()));
+    ++stream->appended;
+    worker.backlog_bytes += message.size();
+    return true;
+}
+
+void AsyncBackend::write_next(Worker& worker, SinkStream& stream) {
+    std::uint32_t length = stream.lengths[stream.next];
+    try {
+        stream.sink->write(std::string_view(stream.data).substr(stream.offset, length));
+    } catch (...) {
+        // Same policy as process_record()
+    }
+    stream.offset += length;
+    ++stream.next;
+    ++stream.written;
+    worker.backlog_bytes -= length;
+
+    // Drop the written prefix once it dominates, so a stream that stays
+    // backlogged does not grow without bound
+    constexpr std::size_t kCompactBytes = 64 * 1024;
+    if (stream.offset >= kCompactBytes && stream.offset * 2 >= stream.data.size()) {
+        stream.data.erase(0, stream.offset);
+        stream.lengths.erase(stream.lengths.begin(),
+                             stream.lengths.begin() + static_cast<std::ptrdiff_t>(stream.next));
+        stream.offset = 0;
+        stream.next = 0;
+    }
+}
+
+void AsyncBackend::finish_backlog(Worker& worker, SinkStream& stream) {
+    try {
+        stream.sink->on_batch_end();
+    } catch (...) {
+    }
+    stream.data.clear();
+    stream.lengths.clear();
+    stream.next = 0;
+    stream.offset = 0;
+    stream.sink.reset();
+
+    --worker.backlogged_streams;
+    complete_flushes(worker, false);
+}
+
+template <typename Ring>
+std::size_t AsyncBackend::process_ring(Worker& worker, Ring& ring, std::mutex& consumer_mutex,
+                                       std::size_t limit, bool draining) {
     std::size_t count = 0;
+    if (config_.overflow_policy == OverflowPolicy::Overrun) {
+        std::vector<std::byte>& copies = worker.record_copies;
+        copies.clear();
+        worker.copy_sequence.fetch_add(1, std::memory_order_acq_rel);  // Now odd
+        {
+            std::lock_guard<std::mutex> lock(consumer_mutex);
+            while (count < limit) {
+                std::span<std::byte> payload = ring.peek();
+                if (payload.empty()) {
+                    break;
+                }
+                // Keep each copy aligned like the ring keeps its records
+                std::size_t offset = copies.size();
+                copies.resize(offset + detail::record_total_size(payload.size()) -
+                              detail::kRecordHeaderSize);
+                std::memcpy(copies.data() + offset, payload.data(), payload.size());
+                ring.pop();
+                ++count;
+            }
+            ring.release();
+        }
+        notify_space(worker);
+
+        for (std::size_t offset = 0; offset < copies.size();) {
+            auto* record = std::launder(reinterpret_cast<AsyncRecord*>(copies.data() + offset));
+            std::size_t size = sizeof(AsyncRecord) + record->args_size;
+            process_record(worker, *record);
+            offset += detail::record_total_size(size) - detail::kRecordHeaderSize;
+        }
+        write_sink_batches(worker, draining);
+        worker.copy_sequence.fetch_add(1, std::memory_order_acq_rel);  // Even again
+        return count;
+    }
 
-    while (count < config_.batch_size) {
-        auto item = queue_->try_pop();
-        if (!item.has_value()) {
+    while (count < limit) {
+        std::span<std::byte> payload = ring.peek();
+        if (payload.empty()) {
             break;
         }
 
-        // Format and write to sinks
+        // Decode in place; the record is trivially destructible
+        auto* record = std::launder(reinterpret_cast<AsyncRecord*>(payload.data()));
+        process_record(worker, *record);
+
+        ring.pop();
+        ++count;
+    }
+    // Before the space goes back: the records' logger states must live
+    write_sink_batches(worker, draining);
+
+    // Hand the space back to the producers once per batch
+    ring.release();
+    notify_space(worker);
+    return count;
+}
+
+void AsyncBackend::process_record(Worker& worker, const AsyncRecord& record) {
+    std::size_t start = worker.batch_text.size();
+    try {
+        const AsyncLoggerState& logger = *record.logger;
+        const LogSite* site_ptr = SiteRegistry::instance().find(record.site);
+        if (site_ptr == nullptr) {
+            return;  // Ids are registered before they are queued; never expected
+        }
+        const LogSite& site = *site_ptr;
+        // A record fanned out to several workers counts once
+        if (worker.index == static_cast<std::size_t>(std::countr_zero(route_mask(logger)))) {
+            SiteRegistry::count_record(site);
+        }
+        std::span<const std::byte> args(record.args(), record.args_size);
+
+        std::string_view message;
+        if (site.format() == nullptr) {
+            message = std::string_view(reinterpret_cast<const char*>(args.data()), args.size());
+        } else if (logger.text_sinks && logger.formatter->needs_message()) {
+            worker.message_buffer.clear();
+            vformat_to(worker.message_buffer, site.format(), args);
+            message = worker.message_buffer;
+        }
+
+        LogRecord log_record(record.timestamp, record.level, message, logger.name,
+                             site.location(), record.thread_id);
+        log_record.site_id = record.site;
+        if (site.format() != nullptr) {
+            log_record.format = site.format();
+            log_record.format_args = args;
+        }
+
+        bool is_formatted = false;
+        std::size_t length = 0;
+        for (std::size_t i = 0; i < logger.sinks.size(); ++i) {
+            if (!owns_sink(worker, logger, i)) {
+                continue;
+            }
+            // Record sinks encode straight away, in ring order
+            if (logger.record_sinks[i]) {
+                try {
+                    logger.sinks[i]->write_record(log_record);
+                } catch (...) {
+                    // Same policy as below: never let a sink kill the worker
+                }
+                continue;
+            }
+            if (!is_formatted) {
+                logger.formatter->format_to(log_record, worker.batch_text);
+                length = worker.batch_text.size() - start;
+                is_formatted = true;
+            }
+            // Few sinks per worker: a linear search beats hashing
+            const SinkPtr& sink = logger.sinks[i];
+            SinkBatch* batch = nullptr;
+            for (std::size_t j = 0; j < worker.sink_batch_count; ++j) {
+                if (worker.sink_batches[j].sink->get() == sink.get()) {
+                    batch = &worker.sink_batches[j];
+                    break;
+                }
+            }
+            if (batch == nullptr) {
+                if (worker.sink_batch_count == worker.sink_batches.size()) {
+                    worker.sink_batches.emplace_back();
+                }
+                batch = &worker.sink_batches[worker.sink_batch_count++];
+                batch->sink = &sink;
+            }
+            batch->messages.emplace_back(start, length);
+        }
+        note_batch_sinks(worker, logger);
+    } catch (...) {
+        // Swallow exceptions in the worker to prevent crashes
+        // In a production system, we might want to log this somewhere
+        worker.batch_text.resize(start);
+    }
+}
+
+void AsyncBackend::write_sink_batches(Worker& worker, bool draining) {
+    for (SinkBatch& batch : std::span(worker.sink_batches).first(worker.sink_batch_count)) {
+        const SinkPtr& sink = *batch.sink;
+        std::size_t total = 0;
+        worker.batch_views.clear();
+        for (auto [offset, length] : batch.messages) {
+            worker.batch_views.emplace_back(worker.batch_text.data() + offset, length);
+            total += length;
+        }
+
         try {
-            std::string formatted = item->formatter->format(item->record);
-            for (auto& sink : item->sinks) {
-                sink->write(formatted);
+            // Sinks that would block get their records queued, except on
+            // shutdown when everything is written synchronously
+            bool backlogged = false;
+            if (worker.backlogged_streams > 0) {
+                auto it = worker.streams.find(sink.get());
+                backlogged = it != worker.streams.end() && it->second->sink;
+            }
+            if (draining || (!backlogged && !sink->would_block(total))) {
+                sink->write_batch(worker.batch_views);
+            } else {
+                for (std::string_view message : worker.batch_views) {
+                    if (!defer_write(worker, sink, message)) {
+                        sink->write(message);
+                    }
+                }
             }
         } catch (...) {
-            // Swallow exceptions in the worker to prevent crashes
-            // In a production system, we might want to log this somewhere
+            // Same policy as process_record(); the rest of this sink's
+            // messages are lost with the failed write
         }
+        batch.messages.clear();
+    }
+    worker.sink_batch_count = 0;
+    worker.batch_text.clear();
+}
 
-        ++count;
+void AsyncBackend::note_batch_sinks(Worker& worker, const AsyncLoggerState& logger) {
+    // Consecutive records usually come from the same logger
+    if (&logger == worker.batch_logger) {
+        return;
+    }
+    worker.batch_logger = &logger;
+    for (std::size_t i = 0; i < logger.sinks.size(); ++i) {
+        ISink* sink = logger.sinks[i].get();
+        if (owns_sink(worker, logger, i) &&
+            std::find(worker.batch_sinks.begin(), worker.batch_sinks.end(), sink) ==
+                worker.batch_sinks.end()) {
+            worker.batch_sinks.push_back(sink);
+            // Until the next flush request; usually already listed
+            if (std::find(worker.unflushed_sinks.begin(), worker.unflushed_sinks.end(),
+                          logger.sinks[i]) == worker.unflushed_sinks.end()) {
+                worker.unflushed_sinks.push_back(logger.sinks[i]);
+            }
+        }
+    }
+}
+
+void AsyncBackend::end_batch(Worker& worker) {
+    for (ISink* sink : worker.batch_sinks) {
+        try {
+            sink->on_batch_end();
+        } catch (...) {
+            // Same policy as process_record(): never let a sink kill the worker
+        }
+    }
+    worker.batch_sinks.clear();
+    worker.batch_logger = nullptr;
+}
+
+std::chrono::microseconds AsyncBackend::run_sink_deadlines(Worker& worker) {
+    // Sinks written since their last flush are the only ones holding data
+    auto now = std::chrono::steady_clock::now();
+    auto next = std::chrono::steady_clock::time_point::max();
+    for (const SinkPtr& sink : worker.unflushed_sinks) {
+        try {
+            auto deadline = sink->batch_end_deadline();
+            if (deadline == std::chrono::steady_clock::time_point{}) {
+                continue;
+            }
+            if (deadline <= now) {
+                sink->on_batch_end();
+                deadline = sink->batch_end_deadline();
+                if (deadline == std::chrono::steady_clock::time_point{}) {
+                    continue;
+                }
+            }
+            next = std::min(next, deadline);
+        } catch (...) {
+            // Same policy as end_batch()
+        }
+    }
+    if (next == std::chrono::steady_clock::time_point::max()) {
+        return std::chrono::microseconds::max();
+    }
+    return std::max(std::chrono::ceil<std::chrono::microseconds>(next - now),
+                    std::chrono::microseconds{1});
+}
+
+std::size_t AsyncBackend::process_batch(Worker& worker) {
+    refresh_producers(worker);
+
+    std::size_t count = worker.queue
+                            ? process_ring(worker, *worker.queue, worker.consumer_mutex,
+                                           config_.batch_size, false)
+                            : process_producers(worker);
+    end_batch(worker);
+    return count;
+}
+
+std::size_t AsyncBackend::process_producers(Worker& worker) {
+    // Round-robin across producer rings: each ring gets an equal share of
+    // the batch so a single busy thread cannot starve the others
+    std::size_t rings = worker.local_producers.size();
+    if (rings == 0) {
+        return 0;
     }
 
-    // Flush sinks after batch if we processed anything
-    // Note: We don't track which sinks were used, so this is a simplification
-    // In a more sophisticated implementation, we'd batch by sink and flush each
+    std::size_t share = std::max<std::size_t>(1, config_.batch_size / rings);
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < rings && count < config_.batch_size; ++i) {
+        std::size_t index = (worker.next_producer + i) % rings;
+        ProducerQueue& producer = *worker.local_producers[index];
 
+        std::size_t processed = process_ring(worker, producer.ring, producer.consumer_mutex, share, false);
+        if (processed == 0 && producer.closed.load(std::memory_order_acquire)) {
+            // Owner is gone and its ring is empty: prune on next refresh
+            worker.producers_version.fetch_add(1, std::memory_order_release);
+        }
+        count += processed;
+    }
+    worker.next_producer = (worker.next_producer + 1) % rings;
     return count;
 }
 
-void AsyncBackend::drain_queue() {
-    if (!queue_) return;
+void AsyncBackend::drain_queue(Worker& worker) {
+    refresh_producers(worker);
 
-    // Process all remaining items
-    while (true) {
-        auto item = queue_->try_pop();
-        if (!item.has_value()) {
-            break;
+    // Backlogs first, so every sink keeps its order; the writes now block
+    for (auto& [sink, stream] : worker.streams) {
+        if (!stream->sink) {
+            continue;
         }
+        while (stream->next < stream->lengths.size()) {
+            write_next(worker, *stream);
+        }
+        finish_backlog(worker, *stream);
+    }
 
-        try {
-            std::string formatted = item->formatter->format(item->record);
-            for (auto& sink : item->sinks) {
-                sink->write(formatted);
-                sink->flush();  // Ensure flush on shutdown
-            }
-        } catch (...) {
-            // Swallow exceptions
+    // Process all remaining records
+    if (worker.queue) {
+        while (process_ring(worker, *worker.queue, worker.consumer_mutex, config_.batch_size,
+                            true) > 0) {
         }
     }
+    for (auto& producer : worker.local_producers) {
+        while (process_ring(worker, producer->ring, producer->consumer_mutex,
+                            config_.batch_size, true) > 0) {
+        }
+    }
+    end_batch(worker);
+
+    // Everything queued is written: flush once, then release flush waiters
+    FlushBarrier everything;
+    flush_sinks(worker, everything);
+    complete_flushes(worker, true);
+    resume_waiters(worker);
+    notify_waiters(worker, true);
+
+    // Destroy the suspended coroutines
+    worker.scheduler.clear();
+    worker.streams.clear();
+    worker.dispatcher = {};
 }
 
 }  // namespace CoLog
-
@@ -2,59 +2,207 @@
 #define COLOG_ASYNC_BACKEND_H
 
 #include <atomic>
+#include <bit>
 #include <chrono>
-#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "../format.h"
 #include "../formatter.h"
+#include "../os.h"
 #include "../record.h"
 #include "../sink.h"
-#include "lock_free_queue.h"
+#include "byte_ring.h"
+#include "epoch.h"
+#include "file_compressor.h"
+#include "scheduler.h"
 
 namespace CoLog {
 
+/**
+ * @brief How producer threads hand records to the backend.
+ */
+enum class QueueMode {
+    Shared,     // One MPSC ring buffer shared by all producer threads
+    PerThread   // One SPSC ring buffer per producer thread, created on first use
+};
+
+/**
+ * @brief What a producer does when its ring is full.
+ */
+enum class OverflowPolicy {
+    Yield,         // Wait, calling std::this_thread::yield() between retries
+    Park,          // Wait, sleeping on std::atomic::wait until the worker frees space
+    SpinThenPark,  // Wait, spinning AsyncConfig::spin_before_park retries before parking
+    Discard,       // Drop the new record
+    Overrun        // Drop the oldest queued records to make room
+};
+
 /**
  * @brief Configuration for the async backend.
  */
 struct AsyncConfig {
-    std::size_t queue_size = 8192;                                     // Queue capacity
-    std::chrono::milliseconds flush_interval{100};                     // Max time between flushes
+    std::size_t queue_bytes = 1 << 20;                                 // Ring buffer capacity in bytes (per thread in PerThread mode)
+    std::chrono::milliseconds flush_interval{100};                     // Retry interval for deferred work (retired loggers) while idle
     std::size_t batch_size = 256;                                      // Max records per batch
-    bool discard_on_full = false;                                      // Discard if queue full vs block
+    OverflowPolicy overflow_policy = OverflowPolicy::SpinThenPark;     // Full-queue behaviour
+    std::size_t spin_before_park = 1024;                               // Retries before parking (SpinThenPark)
+    bool discard_on_full = false;                                      // Shorthand for OverflowPolicy::Discard
+    QueueMode queue_mode = QueueMode::Shared;                          // Shared MPSC vs per-thread SPSC rings
+    std::size_t worker_count = 1;                                      // Worker threads; each sink is pinned to one (max kMaxWorkers)
+    std::size_t compression_threads = 1;                               // Helper threads compressing finished files
+    std::uint64_t compression_bytes_per_second = 0;                    // Compression input rate limit (0 = unlimited)
+
+    // Resumes coroutines suspended in AsyncLogger::log_async() or
+    // flush_wait_async() once they can continue, e.g. by posting the handle
+    // to the application's executor. If unset they are resumed on the
+    // backend worker thread, so they should hand off any real work.
+    std::function<void(std::coroutine_handle<>)> resume_waiter;
 };
 
 /**
- * @brief Async log item stored in the queue.
- * 
- * Contains all information needed to format and write a log record.
+ * @brief Backpressure counters of the async backend, since start().
  */
-struct AsyncLogItem {
-    LogRecord record;
+struct AsyncCounters {
+    std::uint64_t queue_full = 0;  // Records that found their ring full
+    std::uint64_t parked = 0;      // Times a producer slept waiting for space
+    std::uint64_t discarded = 0;   // New records dropped (Discard, shutdown, worker threads)
+    std::uint64_t overrun = 0;     // Queued records dropped to make room (Overrun)
+};
+
+/**
+ * @brief A flush in flight, from AsyncBackend::request_flush().
+ *
+ * Each worker it names completes it once every record queued to the
+ * worker before the request has been formatted and written, and then the
+ * sinks written since their last flush have been flushed.
+ */
+struct FlushBarrier {
+    // Scoped to one logger: only flush these sinks. Otherwise every sink.
+    std::vector<SinkPtr> sinks;
+    bool all_sinks = true;
+
+    // Workers yet to complete it, one bit each
+    std::atomic<std::uint64_t> remaining{0};
+
+    // Set to 1 once `remaining` is zero; wait_for_flush() sleeps on it
+    std::atomic<std::uint32_t> done{0};
+};
+
+/**
+ * @brief Immutable snapshot of an AsyncLogger's output configuration.
+ *
+ * Registered with the backend once per configuration change; queued
+ * records carry a raw pointer to the snapshot that was current when they
+ * were logged, so the hot path touches no reference counts and
+ * reconfiguring a logger never affects queued records.
+ */
+struct AsyncLoggerState {
+    std::string name;
     FormatterPtr formatter;
     std::vector<SinkPtr> sinks;
 
-    AsyncLogItem() = default;
-    AsyncLogItem(LogRecord rec, FormatterPtr fmt, std::vector<SinkPtr> snks)
-        : record(std::move(rec)), 
-          formatter(std::move(fmt)), 
-          sinks(std::move(snks)) {}
+    // Filled in by AsyncBackend::register_logger(): the shard of each sink
+    // (parallel to `sinks`). A sink is written by worker shard % workers.
+    std::vector<std::uint32_t> sink_shards;
+
+    // Also filled in by register_logger(): which sinks take records rather
+    // than text (ISink::writes_records()), and whether any sink takes text
+    std::vector<bool> record_sinks;
+    bool text_sinks = false;
+};
+
+/**
+ * @brief Fixed-size prefix of a record encoded in the ring buffer.
+ * 
+ * Followed directly by `args_size` bytes: the encoded format arguments, or
+ * the raw message text when the site's format is null. The format string
+ * and source location live in the SiteRegistry under `site`, so only the
+ * id is queued. Constructed in place by the
+ * producer; trivially destructible, so the backend simply drops it once
+ * processed.
+ */
+struct AsyncRecord {
+    const AsyncLoggerState* logger;
+    std::chrono::system_clock::time_point timestamp;
+    std::uint64_t thread_id;
+    std::uint32_t site;
+    std::uint32_t args_size;
+    LogLevel level;
+
+    std::byte* args() { return reinterpret_cast<std::byte*>(this + 1); }
+    const std::byte* args() const { return reinterpret_cast<const std::byte*>(this + 1); }
+};
+
+static_assert(alignof(AsyncRecord) <= detail::kRecordAlignment);
+static_assert(std::is_trivially_destructible_v<AsyncRecord>);
+
+/**
+ * @brief Ring buffer owned by one producer thread in QueueMode::PerThread.
+ *
+ * A producer thread has one per worker it has sent records to. `closed`
+ * is set when the owning thread exits; the worker drops the ring once it
+ * has been drained.
+ */
+struct ProducerQueue {
+    explicit ProducerQueue(std::size_t capacity) : ring(capacity) {}
+
+    LocalByteRing ring;
+    std::atomic<bool> closed{false};
+
+    // Consumer side of the ring under OverflowPolicy::Overrun, where the
+    // producer drops the oldest records itself
+    std::mutex consumer_mutex;
 };
 
 /**
  * @brief Centralized async backend for processing log records.
  * 
- * The AsyncBackend runs a dedicated background worker thread that:
- * - Dequeues log records from the lock-free queue
- * - Batches records for efficiency
- * - Formats and writes to sinks
- * - Handles graceful shutdown with queue drain
+ * The AsyncBackend runs a pool of AsyncConfig::worker_count background
+ * worker threads, each with its own queue(s), that:
+ * - Dequeue log records from their lock-free queues
+ * - Batch records for efficiency
+ * - Format and write to sinks
+ * - Handle graceful shutdown with queue drain
+ *
+ * Every sink is pinned to one worker (sink shard % worker count), so each
+ * sink is only ever written by one thread and keeps the order of its
+ * records. A record is queued to each worker owning one of its logger's
+ * sinks (normally just one) and that worker writes it to those sinks only.
+ *
+ * Each worker thread runs a small coroutine scheduler. A dispatcher
+ * coroutine dequeues batches and writes every record straight to its
+ * sinks. When a sink reports that a write would block (ISink::would_block,
+ * e.g. all io_uring buffers in flight), the worker gives the sink a stream
+ * coroutine instead: its records are queued there and written as its I/O
+ * completes, while the dispatcher keeps serving the worker's other sinks.
  */
 class AsyncBackend {
 public:
+    static constexpr std::size_t kMaxWorkers = 64;
+
+    // How often a worker retries sinks that would block
+    static constexpr std::chrono::microseconds kSinkPollInterval{200};
+
+    // How long an idle worker keeps yielding before it goes to sleep; under
+    // steady load the next record is usually this close, and producers
+    // only pay for a wakeup when the worker sleeps
+    static constexpr std::chrono::microseconds kIdleSpin{50};
+
+    // How long process exit waits for files still being compressed
+    static constexpr std::chrono::milliseconds kExitCompressionTimeout{5000};
+
     /**
      * @brief Get the singleton instance of the async backend.
      */
@@ -68,6 +216,12 @@ public:
 
     /**
      * @brief Stop the async backend and flush remaining items.
+     *
+     * Also waits for the FileCompressor to finish the files queued so far
+     * (without its rate limit), within the same timeout.
+     *
+     * Must not be called under an EpochGuard: the rings are freed only
+     * once every producer that saw the backend running has left.
      * @param timeout Maximum time to wait for queue to drain.
      */
     void stop(std::chrono::milliseconds timeout = std::chrono::seconds(5));
@@ -78,11 +232,110 @@ public:
     bool is_running() const { return running_.load(std::memory_order_acquire); }
 
     /**
-     * @brief Submit a log item to the queue.
-     * @param item The log item to submit.
-     * @return true if submitted successfully, false if queue is full (when discard_on_full is true).
+     * @brief Register a logger configuration with the backend.
+     *
+     * Assigns a shard to every sink seen for the first time.
+     * @return Handle to pass to submit(); valid until retire_logger().
+     */
+    const AsyncLoggerState* register_logger(AsyncLoggerState state);
+
+    /**
+     * @brief Retire a handle after it has been unpublished by its logger.
+     *
+     * The state is freed once no thread can still be submitting with it
+     * (an epoch grace period) and every record referring to it has been
+     * processed.
+     */
+    void retire_logger(const AsyncLoggerState* state);
+
+    /**
+     * @brief Submit a deferred-format record to the queue.
+     * 
+     * The arguments are encoded straight into the ring buffer; formatting
+     * happens on the worker thread. @p site is the call site's registry id
+     * (FormatString::site_id()). The caller must hold an EpochGuard from
+     * before it loaded @p logger until this returns.
+     * @return true if submitted successfully, false if the record was dropped
+     *         (OverflowPolicy::Discard, or the backend is stopping).
+     */
+    template <FormatArgument... Args>
+    bool submit(const AsyncLoggerState* logger, LogLevel level, std::uint32_t site,
+                const Args&... args) {
+        std::size_t args_size = encoded_args_size(args...);
+        auto timestamp = std::chrono::system_clock::now();
+        bool submitted = true;
+        for (std::uint64_t routes = route_mask(*logger); routes != 0; routes &= routes - 1) {
+            auto worker = static_cast<std::size_t>(std::countr_zero(routes));
+            AsyncRecord* record =
+                reserve_record(worker, logger, level, site, args_size, timestamp, true);
+            if (record == nullptr) {
+                submitted = false;
+                continue;
+            }
+            encode_args(record->args(), args...);
+            commit_record(reinterpret_cast<std::byte*>(record));
+            notify_committed(*workers_[worker]);
+        }
+        return submitted;
+    }
+
+    /**
+     * @brief Submit a deferred-format record without waiting for queue space.
+     *
+     * Queues the record to the workers in @p routes (a subset of
+     * route_mask()) whose rings have room, and wakes the others. Same epoch
+     * requirement as submit().
+     * @return The routes whose ring was full (0 once everything is queued,
+     *         or if the backend is stopping or not running).
+     */
+    template <FormatArgument... Args>
+    std::uint64_t try_submit(const AsyncLoggerState* logger, std::uint64_t routes,
+                             LogLevel level, std::uint32_t site,
+                             std::chrono::system_clock::time_point timestamp,
+                             const Args&... args) {
+        if (!is_running() || stop_requested_.load(std::memory_order_relaxed)) {
+            return 0;
+        }
+        std::size_t args_size = encoded_args_size(args...);
+        std::uint64_t full = 0;
+        for (; routes != 0; routes &= routes - 1) {
+            auto worker = static_cast<std::size_t>(std::countr_zero(routes));
+            AsyncRecord* record =
+                reserve_record(worker, logger, level, site, args_size, timestamp, false);
+            if (record == nullptr) {
+                full |= routes & -routes;
+                continue;
+            }
+            encode_args(record->args(), args...);
+            commit_record(reinterpret_cast<std::byte*>(record));
+            notify_committed(*workers_[worker]);
+        }
+        return full;
+    }
+
+    /**
+     * @brief Bit set of the workers that must receive @p logger's records.
      */
-    bool submit(AsyncLogItem item);
+    std::uint64_t route_mask(const AsyncLoggerState& logger) const {
+        std::size_t workers = worker_count_.load(std::memory_order_relaxed);
+        if (workers <= 1 || logger.sink_shards.empty()) {
+            return 1;
+        }
+        std::uint64_t mask = 0;
+        for (std::uint32_t shard : logger.sink_shards) {
+            mask |= std::uint64_t{1} << (shard % workers);
+        }
+        return mask;
+    }
+
+    /**
+     * @brief Submit an already formatted message to the queue.
+     *
+     * Same epoch requirement as the deferred-format overload.
+     * @return true if submitted successfully, false if the record was dropped.
+     */
+    bool submit(const AsyncLoggerState* logger, LogLevel level, std::string_view message,
+                std::source_location loc);
 
     /**
      * @brief Request an immediate flush of pending items.
@@ -93,18 +346,249 @@ public:
     void flush();
 
     /**
-     * @brief Wait until all currently queued items have been processed.
+     * @brief Wait until all currently queued items have been written and
+     * their sinks flushed.
      * @param timeout Maximum time to wait.
      * @return true if queue was drained, false if timeout occurred.
      */
     bool wait_for_drain(std::chrono::milliseconds timeout = std::chrono::seconds(5));
 
     /**
-     * @brief Get approximate number of items in the queue.
+     * @brief Start a flush of everything queued so far.
+     *
+     * Snapshots the write position of each ring of the workers involved;
+     * a worker completes the barrier once it has processed its rings past
+     * those positions, written any backlog they left and flushed the sinks
+     * it wrote since their last flush. With @p logger (caller holds an
+     * EpochGuard), only the workers on its routes take part and only its
+     * sinks are flushed.
+     * @return The barrier, or nullptr if the backend is not running.
      */
-    std::size_t queue_size() const;
+    std::shared_ptr<FlushBarrier> request_flush(const AsyncLoggerState* logger = nullptr);
+
+    /**
+     * @brief Block until @p barrier completes, at most @p timeout.
+     *
+     * Returns at once on a worker thread, which cannot wait for itself.
+     * @return true if it completed.
+     */
+    bool wait_for_flush(const FlushBarrier& barrier, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Awaitable: suspend until worker @p worker makes progress.
+     *
+     * The coroutine is registered with the worker first and then
+     * @p ready() is evaluated, under the worker's waiter lock; if it
+     * returns true (or the backend is stopping) the coroutine does not
+     * suspend. This closes the gap between a failed attempt and the
+     * registration. A worker makes progress when it processes records,
+     * when it completes a flush barrier, and when it stops; the coroutine is
+     * then resumed through AsyncConfig::resume_waiter and must re-check
+     * its condition.
+     */
+    template <typename Ready>
+    auto progress(std::size_t worker, Ready ready) {
+        struct Awaiter {
+            AsyncBackend& backend;
+            std::size_t worker;
+            Ready ready;
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> handle) {
+                return backend.add_waiter(worker, handle, ready);
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this, worker, std::move(ready)};
+    }
+
+    /**
+     * @brief Get approximate number of bytes waiting in the queue(s).
+     */
+    std::size_t pending_bytes() const;
+
+    /**
+     * @brief Backpressure counters, summed over all workers (zero once
+     * the backend has stopped).
+     */
+    AsyncCounters counters() const;
+
+    /**
+     * @brief Number of worker threads of the running backend.
+     */
+    std::size_t worker_count() const { return worker_count_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Low-priority helper that compresses finished log files.
+     *
+     * Usable whether or not the backend is running; configured from
+     * AsyncConfig on start().
+     */
+    FileCompressor& compressor() { return compressor_; }
+
+    /**
+     * @brief Queue a file a sink has just closed for compression.
+     *
+     * Backs the sinks' compress-on-close option. Files closed before the
+     * singleton is destroyed at exit are compressed by then (for up to
+     * kExitCompressionTimeout). Does nothing for Compression::None, or
+     * once the singleton has been destroyed (sinks owned by other statics
+     * can outlive it); the file is then left as it is. Compression errors
+     * are not reported.
+     */
+    static void compress_closed_file(std::string path, Compression codec) noexcept;
 
 private:
+    /**
+     * @brief Records held back for a sink whose writes would block.
+     *
+     * Owned by a worker; `task` writes the backlog in order once `pending`
+     * is set, polling the sink between writes, then goes back to waiting.
+     * `sink` keeps the sink alive only while there is a backlog.
+     */
+    struct SinkStream {
+        explicit SinkStream(detail::Scheduler& scheduler) : pending(scheduler) {}
+
+        SinkPtr sink;
+        std::string data;                    // Backlogged messages, back to back
+        std::vector<std::uint32_t> lengths;  // Length of each message in `data`
+        std::size_t next = 0;                // First unwritten message
+        std::size_t offset = 0;              // Its offset in `data`
+        std::uint64_t appended = 0;          // Messages ever backlogged
+        std::uint64_t written = 0;           // Of which written
+        detail::Event pending;
+        detail::Task task;
+    };
+
+    /**
+     * @brief One sink's share of the batch being processed: where its
+     * messages are in Worker::batch_text, in order.
+     *
+     * `sink` points into the logger state of the records, which stays
+     * alive until their ring space is released (under Overrun, until the
+     * copies are processed).
+     */
+    struct SinkBatch {
+        const SinkPtr* sink = nullptr;
+        std::vector<std::pair<std::size_t, std::size_t>> messages;  // Offset, length
+    };
+
+    /**
+     * @brief A worker's part of a FlushBarrier.
+     *
+     * Complete once the worker's rings are processed past the snapshot
+     * positions and, from then on, once each stream that had a backlog has
+     * written past its `appended` count at that moment.
+     */
+    struct FlushRequest {
+        std::shared_ptr<FlushBarrier> barrier;
+        std::size_t shared_position = 0;  // Shared mode
+        std::vector<std::pair<std::shared_ptr<ProducerQueue>, std::size_t>> positions;
+        bool reached = false;
+        std::vector<std::pair<const SinkStream*, std::uint64_t>> backlogs;
+    };
+
+    /**
+     * @brief One worker thread and everything only it touches.
+     *
+     * Producers reach a worker through its shared ring (Shared mode) or
+     * through the per-thread rings registered in `producers` under the
+     * backend's producers_mutex_ (PerThread mode); the worker keeps its own
+     * snapshot in `local_producers` and round-robins over it.
+     */
+    struct Worker {
+        explicit Worker(std::size_t worker_index) : index(worker_index), idle(scheduler) {}
+
+        const std::size_t index;
+
+        // Queue (Shared mode), and its consumer lock under Overrun
+        std::unique_ptr<SharedByteRing> queue;
+        mutable std::mutex consumer_mutex;
+
+        // Per-thread rings (PerThread mode)
+        std::vector<std::shared_ptr<ProducerQueue>> producers;
+        std::atomic<std::uint64_t> producers_version{0};
+        std::vector<std::shared_ptr<ProducerQueue>> local_producers;
+        std::uint64_t local_producers_version = 0;
+        std::size_t next_producer = 0;
+
+        // Scratch buffers, reused across records so steady-state
+        // processing does not allocate
+        std::string message_buffer;
+
+        // Records of the batch being processed, formatted back to back, and
+        // each sink's share of them (the first sink_batch_count entries)
+        std::string batch_text;
+        std::vector<SinkBatch> sink_batches;
+        std::size_t sink_batch_count = 0;
+        std::vector<std::string_view> batch_views;
+
+        // Records copied out of a ring under Overrun, so the ring space can
+        // be released before they are written
+        std::vector<std::byte> record_copies;
+
+        // Odd while copied records are being processed; lets
+        // collect_retired() tell when copies of a retired state are gone
+        std::atomic<std::uint64_t> copy_sequence{0};
+
+        // Producers parked on a full ring sleep on space_epoch, which the
+        // worker bumps after releasing space while any are parked
+        std::atomic<std::uint32_t> space_epoch{0};
+        std::atomic<std::uint32_t> parked_producers{0};
+
+        // Backpressure counters (slow path only)
+        std::atomic<std::uint64_t> queue_full{0};
+        std::atomic<std::uint64_t> parked{0};
+        std::atomic<std::uint64_t> discarded{0};
+        std::atomic<std::uint64_t> overrun{0};
+
+        // Sinks written since the last end_batch(); raw pointers are safe
+        // since retired logger states are only collected between batches
+        std::vector<ISink*> batch_sinks;
+        const AsyncLoggerState* batch_logger = nullptr;
+
+        // Coroutines: the dispatcher parks on `idle` when its queues are
+        // empty and is resumed after the thread's next wait
+        detail::Scheduler scheduler;
+        detail::Event idle;
+        detail::Task dispatcher;
+        bool throttled = false;  // Dispatcher paused until backlogs shrink
+
+        // Streams of sinks that would have blocked, by sink
+        std::unordered_map<const ISink*, std::unique_ptr<SinkStream>> streams;
+        std::size_t backlogged_streams = 0;
+        std::size_t backlog_bytes = 0;
+
+        std::thread thread;
+
+        // Wakeups (see wait_for_work()): the worker publishes `sleeping` and then
+        // re-checks its queues before waiting on wake_word; whoever clears
+        // `sleeping` bumps the word. Own cache line, as producers read
+        // `sleeping` after every commit.
+        alignas(kCacheLineSize) std::atomic<bool> sleeping{false};
+        std::atomic<std::uint32_t> wake_word{0};
+        std::atomic<bool> flush_requested{false};
+
+        // Flush barriers handed to this worker (under flush_mutex), and
+        // the ones it is working on
+        alignas(kCacheLineSize) std::mutex flush_mutex;
+        std::vector<FlushRequest> flush_requests;
+        std::atomic<std::size_t> flush_request_count{0};
+        std::vector<FlushRequest> flushes;
+
+        // Sinks written since they were last flushed, kept alive until then
+        // (at the latest, the final drain)
+        std::vector<SinkPtr> unflushed_sinks;
+
+        // Coroutines waiting for this worker's progress (see progress())
+        std::mutex waiters_mutex;
+        std::vector<std::coroutine_handle<>> waiters;
+        std::atomic<std::size_t> waiter_count{0};
+
+        // Waiters to resume on this thread (no resume_waiter configured)
+        std::vector<std::coroutine_handle<>> resumable;
+    };
+
     AsyncBackend() = default;
     ~AsyncBackend();
 
@@ -113,40 +597,340 @@ private:
     AsyncBackend& operator=(const AsyncBackend&) = delete;
 
     /**
-     * @brief Main worker loop running on the background thread.
+     * @brief True if sink @p index of @p logger is written by @p worker.
      */
-    void worker_loop();
+    bool owns_sink(const Worker& worker, const AsyncLoggerState& logger,
+                   std::size_t index) const {
+        std::size_t workers = worker_count_.load(std::memory_order_relaxed);
+        return workers <= 1 || logger.sink_shards[index] % workers == worker.index;
+    }
 
     /**
-     * @brief Process a batch of items from the queue.
+     * @brief Get (or lazily create and register) the calling thread's ring
+     * for @p worker.
+     */
+    ProducerQueue* local_queue(Worker& worker);
+
+    /**
+     * @brief Reserve ring space for a record and construct its prefix.
+     * 
+     * If @p blocking, a full ring is handled per the OverflowPolicy, except
+     * on worker threads, which cannot wait for themselves and discard.
+     * @return The record to fill in and commit, or nullptr if dropped (or
+     *         full, when not @p blocking).
+     */
+    AsyncRecord* reserve_record(std::size_t worker, const AsyncLoggerState* logger,
+                                LogLevel level, std::uint32_t site, std::size_t args_size,
+                                std::chrono::system_clock::time_point timestamp,
+                                bool blocking);
+
+    /**
+     * @brief Reserve raw payload bytes in @p worker's ring for the current mode.
+     */
+    std::byte* try_reserve(Worker& worker, std::size_t size);
+
+    /**
+     * @brief Slow path of reserve_record() for a full ring: wait, park,
+     * discard or overrun per the OverflowPolicy.
+     */
+    std::byte* reserve_full(Worker& worker, std::size_t size);
+
+    /**
+     * @brief Sleep until @p worker frees ring space, unless a retry
+     * after announcing ourselves succeeds.
+     * @return The reservation if the retry succeeded, else nullptr.
+     */
+    std::byte* park(Worker& worker, std::size_t size);
+
+    /**
+     * @brief Drop the oldest committed record of the calling thread's ring
+     * for @p worker (OverflowPolicy::Overrun).
+     * @return False if there was none to drop.
+     */
+    bool drop_oldest(Worker& worker);
+
+    /**
+     * @brief Wake producers parked on @p worker after it released space.
+     */
+    void notify_space(Worker& worker);
+
+    /**
+     * @brief Wake @p worker so it processes its queue and flush requests now.
+     */
+    void wake(Worker& worker);
+
+    /**
+     * @brief Wake @p worker after a commit if it went to sleep on empty
+     * queues (the empty to non-empty transition). Costs a fence and a load
+     * otherwise; only the producer that clears `sleeping` makes the call.
+     */
+    void notify_committed(Worker& worker) {
+        // Pairs with the fence in wait_for_work(): either the worker sees the
+        // record, or we see it asleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (worker.sleeping.load(std::memory_order_relaxed) &&
+            worker.sleeping.exchange(false, std::memory_order_relaxed)) {
+            wake_worker(worker);
+        }
+    }
+
+    /**
+     * @brief Bump @p worker's wake word and wake it.
+     */
+    void wake_worker(Worker& worker);
+
+    /**
+     * @brief Sleep until woken, for at most @p timeout, unless the worker
+     * has something to do.
+     */
+    void wait_for_work(Worker& worker, std::chrono::microseconds timeout);
+
+    /**
+     * @brief True if the worker loop must not sleep.
+     */
+    bool has_work(const Worker& worker) const;
+
+    /**
+     * @brief Register @p handle as waiting on @p index unless @p ready()
+     * (see progress()).
+     * @return True if the coroutine stays suspended.
+     */
+    template <typename Ready>
+    bool add_waiter(std::size_t index, std::coroutine_handle<> handle, Ready& ready) {
+        if (index >= workers_.size()) {
+            return false;
+        }
+        Worker& worker = *workers_[index];
+        std::lock_guard<std::mutex> lock(worker.waiters_mutex);
+        worker.waiters.push_back(handle);
+        worker.waiter_count.fetch_add(1, std::memory_order_seq_cst);
+        // Pairs with the fence in notify_waiters(): either the worker sees
+        // the registration or ready() sees the worker's progress
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        bool done = true;
+        if (running_.load(std::memory_order_acquire)) {
+            try {
+                done = ready();
+            } catch (...) {
+                // Never leave a registered handle behind an exception
+            }
+        }
+        if (done) {
+            worker.waiters.pop_back();
+            worker.waiter_count.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return !done;
+    }
+
+    /**
+     * @brief Resume every coroutine waiting on @p worker.
+     * @param now Resume them right here (shutdown) instead of from the
+     *        worker loop when no resume_waiter is configured.
+     */
+    void notify_waiters(Worker& worker, bool now);
+
+    /**
+     * @brief Resume the waiters notify_waiters() left to this worker.
+     */
+    void resume_waiters(Worker& worker);
+
+    /**
+     * @brief Complete the flush requests the worker has caught up with.
+     * @param all Complete every request regardless (on exit, after the
+     *        final drain).
+     */
+    void complete_flushes(Worker& worker, bool all);
+
+    /**
+     * @brief Flush the worker's unflushed sinks that @p barrier covers.
+     */
+    void flush_sinks(Worker& worker, const FlushBarrier& barrier);
+
+    /**
+     * @brief Mark @p worker's part of @p barrier done, waking its waiters.
+     */
+    static void finish_flush(std::size_t worker, FlushBarrier& barrier);
+
+    /**
+     * @brief Refresh the worker's view of its registered producer rings.
+     */
+    void refresh_producers(Worker& worker);
+
+    /**
+     * @brief Check whether any of the worker's rings has pending records.
+     */
+    bool has_pending(const Worker& worker) const;
+
+    /**
+     * @brief Process up to @p limit committed records from one ring.
+     *
+     * Under OverflowPolicy::Overrun the records are copied out under
+     * @p consumer_mutex and the space released before they are processed,
+     * so producers can drop the oldest records while a sink is slow.
+     * @return Number of records processed.
+     */
+    template <typename Ring>
+    std::size_t process_ring(Worker& worker, Ring& ring, std::mutex& consumer_mutex,
+                             std::size_t limit, bool draining);
+
+    /**
+     * @brief Check one ring for pending records (see has_pending()).
+     */
+    template <typename Ring>
+    bool ring_has_pending(const Ring& ring, std::mutex& consumer_mutex) const;
+
+    /**
+     * @brief Format one record into the batch text and add it to the batch
+     * of each sink of its logger the worker owns.
+     */
+    void process_record(Worker& worker, const AsyncRecord& record);
+
+    /**
+     * @brief Hand each sink its messages of the batch with one
+     * ISink::write_batch() call.
+     *
+     * A sink that is backlogged or would block on the batch gets its
+     * messages one at a time through defer_write() instead; with
+     * @p draining, everything is written synchronously.
+     */
+    void write_sink_batches(Worker& worker, bool draining);
+
+    /**
+     * @brief Free retired logger states that are no longer referenced.
+     * @param in_worker True on a worker thread, where queued records may
+     *        still refer to a state; false once the workers have exited and
+     *        the rings are drained or gone.
+     */
+    void collect_retired(bool in_worker);
+
+    /**
+     * @brief Main loop running on each worker thread: runs the worker's
+     * coroutines and sleeps when none is ready.
+     */
+    void worker_loop(Worker& worker);
+
+    /**
+     * @brief Dispatcher coroutine: dequeues and processes batches until stop.
+     */
+    detail::Task dispatch(Worker& worker);
+
+    /**
+     * @brief Stream coroutine: writes @p stream's backlog whenever it has one.
+     */
+    detail::Task sink_stream(Worker& worker, SinkStream& stream);
+
+    /**
+     * @brief Queue @p message for @p sink if it is backlogged or would block.
+     * @return False if the caller should write it directly.
+     */
+    bool defer_write(Worker& worker, const SinkPtr& sink, std::string_view message);
+
+    /**
+     * @brief Write the next backlogged message of @p stream.
+     */
+    void write_next(Worker& worker, SinkStream& stream);
+
+    /**
+     * @brief End @p stream's batch once its backlog is written.
+     */
+    void finish_backlog(Worker& worker, SinkStream& stream);
+
+    /**
+     * @brief Process a batch of items from the worker's queue(s).
+     * @return Number of items processed.
+     */
+    std::size_t process_batch(Worker& worker);
+
+    /**
+     * @brief Round-robin one batch across the worker's per-thread rings.
      * @return Number of items processed.
      */
-    std::size_t process_batch();
+    std::size_t process_producers(Worker& worker);
+
+    /**
+     * @brief Remember the worker's sinks of @p logger as written in this batch.
+     */
+    void note_batch_sinks(Worker& worker, const AsyncLoggerState& logger);
+
+    /**
+     * @brief Notify every sink written in this batch that it has ended.
+     */
+    void end_batch(Worker& worker);
 
     /**
-     * @brief Drain all remaining items in the queue.
+     * @brief Call on_batch_end() on the worker's sinks whose
+     * batch_end_deadline() has passed, while no batch came to do it.
+     * @return Time until the next deadline, or microseconds::max().
      */
-    void drain_queue();
+    std::chrono::microseconds run_sink_deadlines(Worker& worker);
+
+    /**
+     * @brief Drain all remaining items in the worker's queue(s).
+     */
+    void drain_queue(Worker& worker);
 
     // Configuration
     AsyncConfig config_;
 
-    // Queue
-    std::unique_ptr<LockFreeQueue<AsyncLogItem>> queue_;
+    // Worker pool; rebuilt by start(), kept (idle) after stop()
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<std::size_t> worker_count_{0};
+    std::atomic<std::uint32_t> active_workers_{0};  // stop() waits on it
+
+    // Guards every worker's `producers` list
+    mutable std::mutex producers_mutex_;
+
+    // Incremented on every start() so thread-local queues from a previous
+    // run are never reused
+    std::atomic<std::uint64_t> session_{0};
 
-    // Worker thread
-    std::thread worker_thread_;
+    // Sink -> shard assignment, handed out round-robin on first sight.
+    // Expired sinks are pruned when a logger registers.
+    struct SinkShard {
+        std::weak_ptr<ISink> sink;
+        std::uint32_t shard;
+    };
+    std::mutex shards_mutex_;
+    std::unordered_map<const ISink*, SinkShard> sink_shards_;
+    std::uint32_t next_shard_ = 0;
+
+    /**
+     * @brief A retired logger state waiting to be freed.
+     *
+     * After the epoch grace period every record naming the state has been
+     * committed, so a worker snapshots each ring's write position; the
+     * state is freed once the consumers have released past all of them.
+     */
+    struct RetiredLogger {
+        std::unique_ptr<const AsyncLoggerState> state;
+        std::uint64_t epoch = 0;
+        bool fenced = false;
+        std::vector<std::pair<const SharedByteRing*, std::size_t>> shared_positions;
+        std::vector<std::pair<std::shared_ptr<ProducerQueue>, std::size_t>> positions;
+
+        // Overrun only: once the positions are reached, records may still be
+        // in flight as copies; wait for every worker's copy_sequence to move
+        // on from (or be idle at) this snapshot
+        bool released = false;
+        std::vector<std::uint64_t> copy_sequences;
+    };
+
+    std::mutex retired_mutex_;
+    std::vector<RetiredLogger> retired_;
+    std::atomic<std::size_t> retired_count_{0};
+
+    // started_ is claimed by start() and released at the end of stop();
+    // running_ is set only once workers_ is built, and cleared when the
+    // workers have exited. Outside the worker threads, workers_ is only
+    // read by threads that saw running_ set under an EpochGuard; stop()
+    // waits for them before it frees the rings.
+    std::atomic<bool> started_{false};
     std::atomic<bool> running_{false};
     std::atomic<bool> stop_requested_{false};
 
-    // Synchronization for flush and wait operations
-    std::mutex mutex_;
-    std::condition_variable cv_;
-    std::atomic<bool> flush_requested_{false};
-
-    // For wait_for_drain: track a "generation" that increments each batch
-    std::atomic<std::uint64_t> processed_generation_{0};
-    std::uint64_t wait_target_generation_{0};
+    // Compression of finished files, off the worker thread
+    FileCompressor compressor_;
 };
 
 }  // namespace CoLog
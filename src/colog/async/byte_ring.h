@@ -0,0 +1,288 @@
+#ifndef COLOG_BYTE_RING_H
+#define COLOG_BYTE_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+
+#include "queue_util.h"
+
+namespace CoLog {
+
+namespace detail {
+
+/**
+ * @brief Header in front of every record in a ByteRing.
+ *
+ * `state` is zero until the producer commits; it then holds the total
+ * record length (header + payload, rounded to kRecordAlignment) plus flag
+ * bits. `length` is the exact payload size requested by the producer.
+ */
+struct RingRecordHeader {
+    std::uint32_t state;
+    std::uint32_t length;
+};
+
+constexpr std::size_t kRecordAlignment = 8;
+constexpr std::size_t kRecordHeaderSize = sizeof(RingRecordHeader);
+constexpr std::uint32_t kRecordCommitted = 1u << 31;
+constexpr std::uint32_t kRecordPadding = 1u << 30;
+constexpr std::uint32_t kRecordLengthMask = kRecordPadding - 1;
+
+static_assert(kRecordHeaderSize == kRecordAlignment);
+
+inline std::atomic_ref<std::uint32_t> record_state(std::byte* header) {
+    return std::atomic_ref<std::uint32_t>(reinterpret_cast<RingRecordHeader*>(header)->state);
+}
+
+constexpr std::size_t record_total_size(std::size_t payload) {
+    return (kRecordHeaderSize + payload + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+}  // namespace detail
+
+/**
+ * @brief Publish a record reserved with ByteRing::try_reserve().
+ *
+ * Works for either ring flavour since the header layout is shared.
+ */
+inline void commit_record(std::byte* payload) {
+    std::byte* header = payload - detail::kRecordHeaderSize;
+    auto length = reinterpret_cast<detail::RingRecordHeader*>(header)->length;
+    auto total = static_cast<std::uint32_t>(detail::record_total_size(length));
+    detail::record_state(header).store(total | detail::kRecordCommitted,
+                                       std::memory_order_release);
+}
+
+/**
+ * @brief A bounded ring of variable-length byte records with one consumer.
+ *
+ * Producers reserve exactly the bytes a record needs, encode it in place
+ * and commit it; the consumer reads committed records in place (no copy,
+ * no per-record allocation) and hands the space back with release().
+ *
+ * - MultiProducer = true: producers claim space with a CAS on the write
+ *   position (MPSC), used for the shared queue.
+ * - MultiProducer = false: the write position is owned by one thread and
+ *   reservation is wait-free (SPSC), used for per-thread queues.
+ *
+ * A record that would straddle the end of the buffer is preceded by a
+ * padding record covering the tail, so every payload is contiguous.
+ * Consumed bytes are zeroed before they are released, which guarantees a
+ * header slot reads as "not committed" until its producer commits it.
+ */
+template <bool MultiProducer>
+class ByteRing {
+public:
+    explicit ByteRing(std::size_t capacity)
+        : capacity_(next_power_of_two(capacity < kMinCapacity ? kMinCapacity : capacity)),
+          mask_(capacity_ - 1),
+          buffer_(new (std::align_val_t(kCacheLineSize)) std::byte[capacity_]()) {}
+
+    ~ByteRing() = default;
+
+    // Non-copyable, non-movable
+    ByteRing(const ByteRing&) = delete;
+    ByteRing& operator=(const ByteRing&) = delete;
+    ByteRing(ByteRing&&) = delete;
+    ByteRing& operator=(ByteRing&&) = delete;
+
+    /**
+     * @brief Reserve space for a record of @p size payload bytes.
+     * @return Pointer to the (8-byte aligned) payload, or nullptr if the
+     *         ring does not currently have room. Must be followed by
+     *         commit_record() on the returned pointer.
+     */
+    std::byte* try_reserve(std::size_t size) {
+        const std::size_t total = detail::record_total_size(size);
+        if (total > capacity_ / 2) {
+            return nullptr;  // Can never fit alongside a wrap padding record
+        }
+
+        std::size_t pos = write_pos_.load(std::memory_order_relaxed);
+        std::size_t read = MultiProducer ? read_pos_.load(std::memory_order_acquire)
+                                         : read_cache_;
+        std::size_t needed;
+        while (true) {
+            std::size_t contiguous = capacity_ - (pos & mask_);
+            needed = total <= contiguous ? total : contiguous + total;
+
+            if (pos + needed - read > capacity_) {
+                read = read_pos_.load(std::memory_order_acquire);
+                if constexpr (!MultiProducer) {
+                    read_cache_ = read;
+                }
+                if (static_cast<std::ptrdiff_t>(pos - read) < 0) {
+                    // Our view of the write position is stale
+                    pos = write_pos_.load(std::memory_order_relaxed);
+                    continue;
+                }
+                if (pos + needed - read > capacity_) {
+                    return nullptr;
+                }
+            }
+
+            if constexpr (MultiProducer) {
+                if (write_pos_.compare_exchange_weak(pos, pos + needed,
+                                                     std::memory_order_relaxed)) {
+                    break;
+                }
+            } else {
+                write_pos_.store(pos + needed, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        std::byte* header = buffer_.get() + (pos & mask_);
+        if (needed != total) {
+            // Fill the tail of the buffer with a padding record and wrap
+            auto padding = static_cast<std::uint32_t>(needed - total);
+            detail::record_state(header).store(
+                padding | detail::kRecordCommitted | detail::kRecordPadding,
+                std::memory_order_release);
+            header = buffer_.get();
+        }
+
+        reinterpret_cast<detail::RingRecordHeader*>(header)->length =
+            static_cast<std::uint32_t>(size);
+        return header + detail::kRecordHeaderSize;
+    }
+
+    /**
+     * @brief Next committed record, or an empty span if none is ready.
+     *
+     * Consumer only. The span stays valid until release().
+     */
+    std::span<std::byte> peek() {
+        // Once a full ring's worth has been popped, the bytes ahead of the
+        // cursor are our own unreleased records; wait for release()
+        const std::size_t read = read_pos_.load(std::memory_order_relaxed);
+        while (cursor_ - read < capacity_) {
+            std::byte* header = buffer_.get() + (cursor_ & mask_);
+            std::uint32_t state = detail::record_state(header).load(std::memory_order_acquire);
+            if ((state & detail::kRecordCommitted) == 0) {
+                return {};
+            }
+
+            std::uint32_t total = state & detail::kRecordLengthMask;
+            if (state & detail::kRecordPadding) {
+                cursor_ += total;
+                continue;
+            }
+
+            current_total_ = total;
+            auto length = reinterpret_cast<detail::RingRecordHeader*>(header)->length;
+            return {header + detail::kRecordHeaderSize, length};
+        }
+        return {};
+    }
+
+    /**
+     * @brief Step past the record returned by the last peek(). Consumer only.
+     */
+    void pop() {
+        cursor_ += current_total_;
+        current_total_ = 0;
+    }
+
+    /**
+     * @brief Return all popped records' space to the producers. Consumer only.
+     */
+    void release() {
+        std::size_t read = read_pos_.load(std::memory_order_relaxed);
+        if (read == cursor_) {
+            return;
+        }
+
+        std::size_t begin = read & mask_;
+        std::size_t length = cursor_ - read;
+        std::size_t first = std::min(length, capacity_ - begin);
+        std::memset(buffer_.get() + begin, 0, first);
+        std::memset(buffer_.get(), 0, length - first);
+
+        read_pos_.store(cursor_, std::memory_order_release);
+    }
+
+    /**
+     * @brief Check for a committed record at the read cursor. Consumer only.
+     */
+    bool has_pending() const {
+        if (cursor_ - read_pos_.load(std::memory_order_relaxed) >= capacity_) {
+            return false;
+        }
+        std::byte* header = buffer_.get() + (cursor_ & mask_);
+        return (detail::record_state(header).load(std::memory_order_acquire) &
+                detail::kRecordCommitted) != 0;
+    }
+
+    /**
+     * @brief Check if the ring is empty.
+     * @note This is only an approximation in a concurrent environment.
+     */
+    bool empty() const { return size_approx() == 0; }
+
+    /**
+     * @brief Approximate number of bytes reserved but not yet released.
+     */
+    std::size_t size_approx() const {
+        std::size_t write = write_pos_.load(std::memory_order_relaxed);
+        std::size_t read = read_pos_.load(std::memory_order_relaxed);
+        return write - read;
+    }
+
+    /**
+     * @brief Total bytes ever reserved. Any thread.
+     */
+    std::size_t write_position() const { return write_pos_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Total bytes ever released by the consumer. Any thread.
+     *
+     * Every record reserved below a write_position() snapshot has been
+     * processed once read_position() reaches it.
+     */
+    std::size_t read_position() const { return read_pos_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Get the capacity of the ring in bytes.
+     */
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    static constexpr std::size_t kMinCapacity = 4096;
+
+    struct AlignedDelete {
+        void operator()(std::byte* p) const {
+            ::operator delete[](p, std::align_val_t(kCacheLineSize));
+        }
+    };
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    std::unique_ptr<std::byte[], AlignedDelete> buffer_;
+
+    // Producer side. read_cache_ is only used by the single producer of an
+    // SPSC ring; MPSC producers read read_pos_ directly.
+    alignas(kCacheLineSize) std::atomic<std::size_t> write_pos_{0};
+    std::size_t read_cache_ = 0;
+
+    // Consumer side
+    alignas(kCacheLineSize) std::atomic<std::size_t> read_pos_{0};
+    std::size_t cursor_ = 0;
+    std::size_t current_total_ = 0;
+
+    // Padding to prevent false sharing with adjacent objects
+    char padding_[kCacheLineSize - sizeof(std::atomic<std::size_t>) - 2 * sizeof(std::size_t)];
+};
+
+using SharedByteRing = ByteRing<true>;
+using LocalByteRing = ByteRing<false>;
+
+}  // namespace CoLog
+
+#endif  // COLOG_BYTE_RING_H
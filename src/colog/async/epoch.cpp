@@ -0,0 +1,100 @@
+#include "epoch.h"
+
+namespace CoLog {
+
+namespace {
+
+/**
+ * @brief The calling thread's participant slot and pin nesting depth.
+ *
+ * Hands the slot back to the manager when the thread exits.
+ */
+struct LocalEpoch {
+    std::atomic<std::uint64_t>* epoch = nullptr;
+    std::atomic<bool>* in_use = nullptr;
+    int depth = 0;
+
+    ~LocalEpoch() {
+        if (in_use != nullptr) {
+            in_use->store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local LocalEpoch t_local_epoch;
+
+}  // namespace
+
+EpochManager& EpochManager::instance() {
+    static EpochManager instance;
+    return instance;
+}
+
+EpochManager::Guard::Guard() {
+    EpochManager::instance().pin();
+}
+
+EpochManager::Guard::~Guard() {
+    EpochManager::instance().unpin();
+}
+
+EpochManager::Participant* EpochManager::acquire_participant() {
+    // Reuse a slot released by an exited thread
+    for (Participant* p = participants_.load(std::memory_order_acquire); p; p = p->next) {
+        bool expected = false;
+        if (!p->in_use.load(std::memory_order_relaxed) &&
+            p->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            return p;
+        }
+    }
+
+    auto* p = new Participant();
+    p->in_use.store(true, std::memory_order_relaxed);
+    Participant* head = participants_.load(std::memory_order_relaxed);
+    do {
+        p->next = head;
+    } while (!participants_.compare_exchange_weak(head, p, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+    return p;
+}
+
+void EpochManager::pin() {
+    LocalEpoch& local = t_local_epoch;
+    if (local.depth++ > 0) {
+        return;
+    }
+    if (local.epoch == nullptr) {
+        Participant* p = acquire_participant();
+        local.epoch = &p->epoch;
+        local.in_use = &p->in_use;
+    }
+
+    local.epoch->store(global_epoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    // Order the pin before any load of a protected pointer
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void EpochManager::unpin() {
+    LocalEpoch& local = t_local_epoch;
+    if (--local.depth > 0) {
+        return;
+    }
+    local.epoch->store(0, std::memory_order_release);
+}
+
+std::uint64_t EpochManager::advance() {
+    return global_epoch_.fetch_add(1, std::memory_order_seq_cst);
+}
+
+bool EpochManager::quiescent_since(std::uint64_t epoch) const {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (Participant* p = participants_.load(std::memory_order_acquire); p; p = p->next) {
+        std::uint64_t pinned = p->epoch.load(std::memory_order_acquire);
+        if (pinned != 0 && pinned <= epoch) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace CoLog
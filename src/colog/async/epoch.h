@@ -0,0 +1,87 @@
+#ifndef COLOG_EPOCH_H
+#define COLOG_EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "queue_util.h"
+
+namespace CoLog {
+
+/**
+ * @brief Epoch-based reclamation for read-mostly shared pointers.
+ *
+ * Readers pin the current epoch with a Guard while they dereference a
+ * published pointer; this costs two thread-local stores and a fence, with
+ * no shared cache line written. A writer that unlinks an object calls
+ * advance() and may free the object once quiescent_since() reports that
+ * every thread pinned at or before that epoch has unpinned.
+ */
+class EpochManager {
+public:
+    /**
+     * @brief Get the process-wide epoch manager.
+     */
+    static EpochManager& instance();
+
+    /**
+     * @brief RAII pin of the calling thread. Nested guards are allowed.
+     */
+    class Guard {
+    public:
+        Guard();
+        ~Guard();
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    /**
+     * @brief Advance the global epoch after unlinking an object.
+     * @return The epoch to pass to quiescent_since() for that object.
+     */
+    std::uint64_t advance();
+
+    /**
+     * @brief Check whether no thread is still pinned at or before @p epoch.
+     */
+    bool quiescent_since(std::uint64_t epoch) const;
+
+private:
+    friend class Guard;
+
+    /**
+     * @brief Per-thread pin slot; reused after its thread exits.
+     */
+    struct alignas(kCacheLineSize) Participant {
+        std::atomic<std::uint64_t> epoch{0};  // 0 = not pinned
+        std::atomic<bool> in_use{false};
+        Participant* next = nullptr;
+    };
+
+    EpochManager() = default;
+    ~EpochManager() = default;
+
+    // Non-copyable
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+    /**
+     * @brief Claim a free slot or append a new one to the list.
+     */
+    Participant* acquire_participant();
+
+    void pin();
+    void unpin();
+
+    std::atomic<std::uint64_t> global_epoch_{1};
+
+    // Append-only list; slots are never freed, only recycled
+    std::atomic<Participant*> participants_{nullptr};
+};
+
+using EpochGuard = EpochManager::Guard;
+
+}  // namespace CoLog
+
+#endif  // COLOG_EPOCH_H
@@ -0,0 +1,137 @@
+#include "file_compressor.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#include "../os.h"
+
+namespace CoLog {
+
+FileCompressor::~FileCompressor() {
+    std::deque<Job> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        abandoned.swap(jobs_);
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    for (auto& job : abandoned) {
+        job.done.set_value(false);
+    }
+}
+
+void FileCompressor::configure(std::size_t max_threads, std::uint64_t bytes_per_second) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_threads_ = max_threads > 0 ? max_threads : 1;
+    bytes_per_second_ = bytes_per_second;
+}
+
+std::future<bool> FileCompressor::submit(std::string path, Compression codec) {
+    Job job{std::move(path), codec, {}};
+    std::future<bool> result = job.done.get_future();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_) {
+        job.done.set_value(false);
+        return result;
+    }
+    jobs_.push_back(std::move(job));
+    if (idle_ == 0 && threads_.size() < max_threads_) {
+        threads_.emplace_back(&FileCompressor::worker_loop, this);
+    } else {
+        cv_.notify_one();
+    }
+    return result;
+}
+
+bool FileCompressor::drain(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    draining_ = true;
+    cv_.notify_all();  // Release jobs waiting out the rate limit
+    bool idle = idle_cv_.wait_for(lock, timeout, [this] { return jobs_.empty() && active_ == 0; });
+    draining_ = false;
+    return idle;
+}
+
+std::size_t FileCompressor::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.size() + active_;
+}
+
+void FileCompressor::worker_loop() {
+    lower_current_thread_priority();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        ++idle_;
+        cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+        --idle_;
+        if (stop_) {
+            return;
+        }
+
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+        ++active_;
+        lock.unlock();
+
+        bool done = run(job);
+        job.done.set_value(done);
+
+        lock.lock();
+        --active_;
+        if (active_ == 0 && jobs_.empty()) {
+            idle_cv_.notify_all();
+        }
+    }
+}
+
+bool FileCompressor::run(const Job& job) {
+    std::string destination = job.path + std::string(compression_extension(job.codec));
+    std::string temporary = destination + ".tmp";
+    std::error_code ec;
+
+    bool done = false;
+    try {
+        // Never replace an earlier compressed file (a sink reopened with
+        // append, say): build a copy of it with this file as a further
+        // frame/member, then swap that in
+        bool append = std::filesystem::exists(destination);
+        if (append) {
+            std::filesystem::copy_file(destination, temporary,
+                                       std::filesystem::copy_options::overwrite_existing);
+        }
+        done = compress_file(job.path, temporary, job.codec,
+                             [this](std::size_t bytes) { return throttle(bytes); }, append);
+        if (done) {
+            std::filesystem::rename(temporary, destination);
+            std::filesystem::remove(job.path, ec);
+        }
+    } catch (...) {
+        done = false;
+    }
+
+    if (!done) {
+        std::filesystem::remove(temporary, ec);
+    }
+    return done;
+}
+
+bool FileCompressor::throttle(std::size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (bytes_per_second_ > 0 && !draining_) {
+        auto now = std::chrono::steady_clock::now();
+        auto cost = std::chrono::nanoseconds(
+            static_cast<std::int64_t>(bytes * 1000000000ULL / bytes_per_second_));
+        // Time spent compressing counts towards the budget; idle time does not bank credit
+        next_slot_ = std::max(next_slot_, now - cost) + cost;
+        cv_.wait_until(lock, next_slot_, [this] { return stop_ || draining_; });
+    }
+    return !stop_;
+}
+
+}  // namespace CoLog
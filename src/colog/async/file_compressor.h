@@ -0,0 +1,107 @@
+#ifndef COLOG_FILE_COMPRESSOR_H
+#define COLOG_FILE_COMPRESSOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../compression.h"
+
+namespace CoLog {
+
+/**
+ * @brief Compresses finished log files on low-priority helper threads.
+ *
+ * Owned by the AsyncBackend so compression never runs on the logging
+ * worker. Helper threads are started on demand up to a fixed budget, run
+ * at the lowest CPU (and, on Linux, idle I/O) priority, and share an input
+ * rate limit, so compressing a backlog of rotated files costs a bounded,
+ * predictable amount of CPU and disk bandwidth.
+ *
+ * `path` is compressed to `path` + codec extension via a temporary file;
+ * the source is removed only once the compressed file is complete. If that
+ * file already exists, the new data is added to it as a further LZ4 frame
+ * or gzip member rather than replacing it.
+ */
+class FileCompressor {
+public:
+    FileCompressor() = default;
+
+    /**
+     * @brief Abandon queued jobs, abort the ones in progress and join.
+     *
+     * Aborted files are left uncompressed.
+     */
+    ~FileCompressor();
+
+    // Non-copyable
+    FileCompressor(const FileCompressor&) = delete;
+    FileCompressor& operator=(const FileCompressor&) = delete;
+
+    /**
+     * @brief Set the thread budget and input rate limit.
+     * @param max_threads Maximum helper threads (at least one).
+     * @param bytes_per_second Input bytes per second across all helpers (0 = unlimited).
+     */
+    void configure(std::size_t max_threads, std::uint64_t bytes_per_second);
+
+    /**
+     * @brief Queue a file for compression.
+     * @return Becomes true once the compressed file has replaced @p path,
+     *         false if compression failed or was aborted.
+     */
+    std::future<bool> submit(std::string path, Compression codec);
+
+    /**
+     * @brief Wait, at most @p timeout, for every queued job to finish.
+     *
+     * The rate limit is lifted meanwhile, so a backlog left at shutdown
+     * is compressed as fast as the helpers can go.
+     * @return true if nothing is left queued or in progress.
+     */
+    bool drain(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Number of jobs queued or in progress.
+     */
+    std::size_t pending() const;
+
+private:
+    struct Job {
+        std::string path;
+        Compression codec;
+        std::promise<bool> done;
+    };
+
+    void worker_loop();
+    bool run(const Job& job);
+
+    /**
+     * @brief Rate-limit hook called after each compressed chunk.
+     * @return false once the compressor is shutting down.
+     */
+    bool throttle(std::size_t bytes);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable idle_cv_;  // Signalled when the last job finishes
+    std::deque<Job> jobs_;
+    std::vector<std::thread> threads_;
+    std::size_t idle_ = 0;
+    std::size_t active_ = 0;
+    std::size_t max_threads_ = 1;
+    std::uint64_t bytes_per_second_ = 0;
+    std::chrono::steady_clock::time_point next_slot_{};
+    bool draining_ = false;  // drain() in progress: no rate limit
+    bool stop_ = false;
+};
+
+}  // namespace CoLog
+
+#endif  // COLOG_FILE_COMPRESSOR_H
@@ -4,18 +4,12 @@
 #include <atomic>
 #include <cstddef>
 #include <memory>
-#include <new>
 #include <optional>
 #include <vector>
 
-namespace CoLog {
+#include "queue_util.h"
 
-// Cache line size for avoiding false sharing
-#ifdef __cpp_lib_hardware_interference_size
-constexpr std::size_t kCacheLineSize = std::hardware_destructive_interference_size;
-#else
-constexpr std::size_t kCacheLineSize = 64;
-#endif
+namespace CoLog {
 
 /**
  * @brief A lock-free Multi-Producer Multi-Consumer (MPMC) bounded queue.
@@ -48,10 +42,11 @@ public:
 
     /**
      * @brief Try to enqueue an item.
-     * @param item The item to enqueue (will be moved).
+     * @param item The item to enqueue (only moved from on success, so a
+     *             failed push can be retried with the same item).
      * @return true if successful, false if the queue is full.
      */
-    bool try_push(T item) {
+    bool try_push(T&& item) {
         Slot* slot;
         std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
 
@@ -146,18 +141,6 @@ private:
         T data;
     };
 
-    static std::size_t next_power_of_two(std::size_t n) {
-        if (n == 0) return 1;
-        n--;
-        n |= n >> 1;
-        n |= n >> 2;
-        n |= n >> 4;
-        n |= n >> 8;
-        n |= n >> 16;
-        n |= n >> 32;
-        return n + 1;
-    }
-
     const std::size_t capacity_;
     const std::size_t mask_;
     std::unique_ptr<Slot[]> buffer_;
@@ -0,0 +1,50 @@
+#ifndef COLOG_QUEUE_UTIL_H
+#define COLOG_QUEUE_UTIL_H
+
+#include <cstddef>
+#include <new>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace CoLog {
+
+// Cache line size for avoiding false sharing
+#ifdef __cpp_lib_hardware_interference_size
+constexpr std::size_t kCacheLineSize = std::hardware_destructive_interference_size;
+#else
+constexpr std::size_t kCacheLineSize = 64;
+#endif
+
+/**
+ * @brief Round up to the next power of two (ring buffers index with a mask).
+ */
+constexpr std::size_t next_power_of_two(std::size_t n) {
+    if (n == 0) return 1;
+    n--;
+    n |= n >> 1;
+    n |= n >> 2;
+    n |= n >> 4;
+    n |= n >> 8;
+    n |= n >> 16;
+    n |= n >> 32;
+    return n + 1;
+}
+
+/**
+ * @brief Tell the CPU we are spin-waiting (x86 `pause`, Arm `yield`).
+ */
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#endif
+}
+
+}  // namespace CoLog
+
+#endif  // COLOG_QUEUE_UTIL_H
@@ -0,0 +1,203 @@
+#ifndef COLOG_SCHEDULER_H
+#define COLOG_SCHEDULER_H
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <vector>
+
+namespace CoLog {
+
+namespace detail {
+
+/**
+ * @brief Coroutine owned by a Scheduler-driven backend worker.
+ *
+ * Starts suspended; the owner hands handle() to a Scheduler, or resumes
+ * it directly after start(). Destroying the Task destroys the coroutine
+ * frame, wherever it is suspended.
+ */
+class Task {
+public:
+    struct promise_type {
+        // Resumed (by symmetric transfer) when the coroutine finishes
+        std::coroutine_handle<> continuation;
+
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<promise_type> handle) const noexcept {
+                std::coroutine_handle<> next = handle.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        // Task coroutines catch everything themselves
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Task() = default;
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~Task() { reset(); }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    std::coroutine_handle<> handle() const { return handle_; }
+
+    /**
+     * @brief Prepare to run as part of @p continuation, e.g. from an
+     * awaiter's await_suspend(): @p continuation resumes when this finishes.
+     * @return The handle to resume (or return from await_suspend()).
+     */
+    std::coroutine_handle<> start(std::coroutine_handle<> continuation) {
+        handle_.promise().continuation = continuation;
+        return handle_;
+    }
+
+    bool done() const { return !handle_ || handle_.done(); }
+
+private:
+    void reset() {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/**
+ * @brief Single-threaded run queue for a backend worker's coroutines.
+ *
+ * Coroutines are resumed in FIFO order by run_ready(). A coroutine that
+ * waits for an external condition with no completion notification (such
+ * as a sink's I/O buffers freeing up) co_awaits poll() and is resumed
+ * after the owner's next wake_polling(). Not thread-safe: everything runs
+ * on the owning worker thread.
+ */
+class Scheduler {
+public:
+    void schedule(std::coroutine_handle<> handle) { ready_.push_back(handle); }
+
+    /**
+     * @brief Resume every coroutine that was ready on entry, in order.
+     *
+     * Coroutines made ready meanwhile (e.g. by yield()) run on the next
+     * call, so the owner regains control between passes.
+     * @return True if anything ran.
+     */
+    bool run_ready() {
+        if (ready_.empty()) {
+            return false;
+        }
+        running_.swap(ready_);
+        for (std::coroutine_handle<> handle : running_) {
+            handle.resume();
+        }
+        running_.clear();
+        return true;
+    }
+
+    /**
+     * @brief Make every polling coroutine ready again.
+     */
+    void wake_polling() {
+        ready_.insert(ready_.end(), polling_.begin(), polling_.end());
+        polling_.clear();
+    }
+
+    bool has_polling() const { return !polling_.empty(); }
+
+    /**
+     * @brief Awaitable: resume on the next run_ready() pass.
+     */
+    auto yield() {
+        struct Awaiter {
+            Scheduler& scheduler;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler.schedule(handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    /**
+     * @brief Awaitable: resume after the next wake_polling().
+     */
+    auto poll() {
+        struct Awaiter {
+            Scheduler& scheduler;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                scheduler.polling_.push_back(handle);
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    /**
+     * @brief Forget all queued handles (their frames are owned by Tasks).
+     */
+    void clear() {
+        ready_.clear();
+        polling_.clear();
+    }
+
+private:
+    std::vector<std::coroutine_handle<>> ready_;
+    std::vector<std::coroutine_handle<>> running_;
+    std::vector<std::coroutine_handle<>> polling_;
+};
+
+/**
+ * @brief Awaitable flag a single coroutine can park on until set().
+ */
+class Event {
+public:
+    explicit Event(Scheduler& scheduler) : scheduler_(scheduler) {}
+
+    bool await_ready() const noexcept { return set_; }
+    void await_suspend(std::coroutine_handle<> handle) { waiter_ = handle; }
+    void await_resume() noexcept { set_ = false; }
+
+    /**
+     * @brief Set the flag, scheduling the parked coroutine if there is one.
+     */
+    void set() {
+        set_ = true;
+        if (waiter_) {
+            scheduler_.schedule(std::exchange(waiter_, {}));
+        }
+    }
+
+    bool waiting() const { return static_cast<bool>(waiter_); }
+
+private:
+    Scheduler& scheduler_;
+    std::coroutine_handle<> waiter_;
+    bool set_ = false;
+};
+
+}  // namespace detail
+
+}  // namespace CoLog
+
+#endif  // COLOG_SCHEDULER_H
@@ -1,23 +1,35 @@
 #include "async_logger.h"
 
-#include "record.h"
+#include "pattern_formatter.h"
 
 namespace CoLog {
 
+namespace {
+
+AsyncLoggerState initial_state(const std::string& name) {
+    AsyncLoggerState state;
+    state.name = name;
+    state.formatter = std::make_shared<PatternFormatter>();
+    return state;
+}
+
+}  // namespace
+
 AsyncLogger::AsyncLogger(std::string name)
     : name_(std::move(name)),
-      formatter_(std::make_shared<PatternFormatter>()) {}
+      state_(AsyncBackend::instance().register_logger(initial_state(name_))) {}
 
 AsyncLogger::~AsyncLogger() {
     // Optionally flush on destruction
     // Note: We don't wait here to avoid blocking in destructor
     flush();
+    AsyncBackend::instance().retire_logger(state_.load(std::memory_order_acquire));
 }
 
 void AsyncLogger::log(LogLevel level, const std::string& message,
                       std::source_location loc) {
     // Early level filtering (fast path - no lock needed)
-    if (level < level_) {
+    if (!should_log(level)) {
         return;
     }
 
@@ -26,14 +38,11 @@ void AsyncLogger::log(LogLevel level, const std::string& message,
         return;  // Silently drop if backend not initialized
     }
 
-    // Create log record (capture timestamp now, not when processed)
-    LogRecord record(level, message, name_, loc);
-
-    // Create async item with copies of formatter and sinks
-    AsyncLogItem item(std::move(record), formatter_, sinks_);
-
-    // Submit to backend queue
-    AsyncBackend::instance().submit(std::move(item));
+    // Copy the message into the queue; the backend captures the timestamp
+    // now, not when processed
+    EpochGuard guard;
+    AsyncBackend::instance().submit(state_.load(std::memory_order_acquire), level, message,
+                                    loc);
 }
 
 void AsyncLogger::trace(const std::string& message, std::source_location loc) {
@@ -61,23 +70,68 @@ void AsyncLogger::critical(const std::string& message, std::source_location loc)
 }
 
 void AsyncLogger::add_sink(SinkPtr sink) {
-    sinks_.push_back(std::move(sink));
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    AsyncLoggerState state = *state_.load(std::memory_order_relaxed);
+    state.sinks.push_back(std::move(sink));
+    replace_state(std::move(state));
 }
 
 void AsyncLogger::set_formatter(FormatterPtr formatter) {
-    formatter_ = std::move(formatter);
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    AsyncLoggerState state = *state_.load(std::memory_order_relaxed);
+    state.formatter = std::move(formatter);
+    replace_state(std::move(state));
+}
+
+void AsyncLogger::replace_state(AsyncLoggerState state) {
+    AsyncBackend& backend = AsyncBackend::instance();
+    const AsyncLoggerState* previous =
+        state_.exchange(backend.register_logger(std::move(state)), std::memory_order_acq_rel);
+    backend.retire_logger(previous);
 }
 
 void AsyncLogger::set_level(LogLevel level) {
-    level_ = level;
+    level_.store(level, std::memory_order_relaxed);
 }
 
 void AsyncLogger::flush() {
     AsyncBackend::instance().flush();
 }
 
+std::shared_ptr<FlushBarrier> AsyncLogger::request_flush() {
+    EpochGuard guard;
+    return AsyncBackend::instance().request_flush(state_.load(std::memory_order_acquire));
+}
+
 bool AsyncLogger::flush_wait(std::chrono::milliseconds timeout) {
-    return AsyncBackend::instance().wait_for_drain(timeout);
+    std::shared_ptr<FlushBarrier> barrier = request_flush();
+    return barrier == nullptr || AsyncBackend::instance().wait_for_flush(*barrier, timeout);
+}
+
+FlushAwaiter AsyncLogger::flush_wait_async() {
+    return FlushAwaiter(request_flush());
+}
+
+bool FlushAwaiter::await_ready() const {
+    return barrier_ == nullptr || barrier_->done.load(std::memory_order_acquire) != 0;
+}
+
+std::coroutine_handle<> FlushAwaiter::await_suspend(std::coroutine_handle<> caller) {
+    wait_ = wait();
+    return wait_.start(caller);
+}
+
+detail::Task FlushAwaiter::wait() {
+    AsyncBackend& backend = AsyncBackend::instance();
+    std::uint64_t remaining;
+    while ((remaining = barrier_->remaining.load(std::memory_order_acquire)) != 0 &&
+           backend.is_running()) {
+        auto worker = static_cast<std::size_t>(std::countr_zero(remaining));
+        co_await backend.progress(worker, [this, worker] {
+            return (barrier_->remaining.load(std::memory_order_acquire) &
+                    (std::uint64_t{1} << worker)) == 0;
+        });
+    }
 }
 
 // Global async management functions
@@ -1,12 +1,20 @@
 #ifndef COLOG_ASYNC_LOGGER_H
 #define COLOG_ASYNC_LOGGER_H
 
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <source_location>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "async/async_backend.h"
+#include "format.h"
 #include "formatter.h"
 #include "level.h"
 #include "pattern_formatter.h"
@@ -14,6 +22,13 @@
 
 namespace CoLog {
 
+class AsyncLogger;
+
+template <FormatArgument... Args>
+class LogAwaiter;
+
+class FlushAwaiter;
+
 /**
  * @brief Async logger that uses the centralized AsyncBackend.
  * 
@@ -26,11 +41,11 @@ public:
     explicit AsyncLogger(std::string name);
     ~AsyncLogger();
 
-    // Non-copyable, movable
+    // Non-copyable, non-movable (the backend holds our state handle)
     AsyncLogger(const AsyncLogger&) = delete;
     AsyncLogger& operator=(const AsyncLogger&) = delete;
-    AsyncLogger(AsyncLogger&&) = default;
-    AsyncLogger& operator=(AsyncLogger&&) = default;
+    AsyncLogger(AsyncLogger&&) = delete;
+    AsyncLogger& operator=(AsyncLogger&&) = delete;
 
     /**
      * @brief Core async logging method.
@@ -55,6 +70,91 @@ public:
     void critical(const std::string& message,
                   std::source_location loc = std::source_location::current());
 
+    /**
+     * @brief Deferred-formatting logging method.
+     *
+     * Only the format string pointer and the encoded arguments are captured
+     * on the calling thread; the message text is built by the async backend:
+     *
+     *     logger->info("req {} took {}us", id, us);
+     */
+    template <FormatArgument... Args>
+    void log(LogLevel level, FormatString<Args...> fmt, const Args&... args) {
+        AsyncBackend& backend = AsyncBackend::instance();
+        if (!should_log(level) || !backend.is_running()) {
+            return;
+        }
+        EpochGuard guard;
+        backend.submit(state_.load(std::memory_order_acquire), level, fmt.site_id(), args...);
+    }
+
+    template <FormatArgument... Args>
+    void trace(FormatString<Args...> fmt, const Args&... args) {
+        log(LogLevel::Trace, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    void debug(FormatString<Args...> fmt, const Args&... args) {
+        log(LogLevel::Debug, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    void info(FormatString<Args...> fmt, const Args&... args) {
+        log(LogLevel::Info, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    void warn(FormatString<Args...> fmt, const Args&... args) {
+        log(LogLevel::Warn, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    void error(FormatString<Args...> fmt, const Args&... args) {
+        log(LogLevel::Error, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    void critical(FormatString<Args...> fmt, const Args&... args) {
+        log(LogLevel::Critical, fmt, args...);
+    }
+
+    /**
+     * @brief Awaitable form of log() for code running in coroutines.
+     *
+     * Where log() would block while the queue is full, this suspends the
+     * calling coroutine and the backend resumes it once the record could
+     * be queued (see AsyncConfig::resume_waiter for where). Never discards
+     * or overruns, whatever AsyncConfig::overflow_policy says. The arguments are
+     * referenced, not copied, so co_await the result straight away:
+     *
+     *     co_await logger->info_async("req {} took {}us", id, us);
+     */
+    template <FormatArgument... Args>
+    LogAwaiter<Args...> log_async(LogLevel level, FormatString<Args...> fmt,
+                                  const Args&... args) {
+        return LogAwaiter<Args...>(*this, level, fmt, args...);
+    }
+
+    template <FormatArgument... Args>
+    LogAwaiter<Args...> trace_async(FormatString<Args...> fmt, const Args&... args) {
+        return log_async(LogLevel::Trace, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    LogAwaiter<Args...> debug_async(FormatString<Args...> fmt, const Args&... args) {
+        return log_async(LogLevel::Debug, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    LogAwaiter<Args...> info_async(FormatString<Args...> fmt, const Args&... args) {
+        return log_async(LogLevel::Info, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    LogAwaiter<Args...> warn_async(FormatString<Args...> fmt, const Args&... args) {
+        return log_async(LogLevel::Warn, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    LogAwaiter<Args...> error_async(FormatString<Args...> fmt, const Args&... args) {
+        return log_async(LogLevel::Error, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    LogAwaiter<Args...> critical_async(FormatString<Args...> fmt, const Args&... args) {
+        return log_async(LogLevel::Critical, fmt, args...);
+    }
+
     // Configuration
     void add_sink(SinkPtr sink);
     void set_formatter(FormatterPtr formatter);
@@ -62,7 +162,13 @@ public:
 
     // Accessors
     const std::string& name() const { return name_; }
-    LogLevel level() const { return level_; }
+    LogLevel level() const { return level_.load(std::memory_order_relaxed); }
+
+    // True if a call at `level` would be logged; constant-folds to false
+    // below COLOG_ACTIVE_LEVEL
+    bool should_log(LogLevel level) const {
+        return is_active(level) && level >= level_.load(std::memory_order_relaxed);
+    }
 
     /**
      * @brief Request the async backend to flush pending items.
@@ -72,21 +178,151 @@ public:
     void flush();
 
     /**
-     * @brief Flush and wait for pending items to be processed.
+     * @brief Wait until everything this logger queued before the call has
+     * been written and its sinks flushed.
+     *
+     * Only the workers writing this logger's sinks take part, and only its
+     * sinks are flushed; AsyncBackend::wait_for_drain() covers everything.
      * @param timeout Maximum time to wait.
      * @return true if all items were flushed, false on timeout.
      */
     bool flush_wait(std::chrono::milliseconds timeout = std::chrono::seconds(5));
 
+    /**
+     * @brief Awaitable flush_wait(): suspends the calling coroutine until
+     * everything this logger queued before the call has been written and
+     * its sinks flushed. No timeout; completes when the backend stops.
+     *
+     *     co_await logger->flush_wait_async();
+     */
+    FlushAwaiter flush_wait_async();
+
 private:
+    template <FormatArgument... Args>
+    friend class LogAwaiter;
+
+    /**
+     * @brief Publish a new configuration and retire the previous one.
+     */
+    void replace_state(AsyncLoggerState state);
+
+    /**
+     * @brief Start a flush barrier scoped to this logger.
+     */
+    std::shared_ptr<FlushBarrier> request_flush();
+
     std::string name_;
-    LogLevel level_ = LogLevel::Trace;
-    std::vector<SinkPtr> sinks_;
-    FormatterPtr formatter_;
+    std::atomic<LogLevel> level_{LogLevel::Trace};  // Read relaxed on the hot path
+
+    // Handle registered with the backend; swapped (never mutated) on
+    // reconfiguration. Writers serialize on config_mutex_, readers pin an
+    // epoch instead of taking a reference.
+    std::atomic<const AsyncLoggerState*> state_;
+    std::mutex config_mutex_;
 };
 
 using AsyncLoggerPtr = std::shared_ptr<AsyncLogger>;
 
+/**
+ * @brief Awaiter returned by AsyncLogger::log_async().
+ *
+ * await_ready() makes one non-blocking attempt, so a record that fits
+ * costs what log() does. Otherwise a retry coroutine takes over: it waits
+ * for a worker whose ring was full to make progress, retries, and resumes
+ * the caller once every worker has the record, or once the backend stops
+ * (the record is then dropped, as log() would drop it).
+ */
+template <FormatArgument... Args>
+class LogAwaiter {
+public:
+    LogAwaiter(AsyncLogger& logger, LogLevel level, FormatString<Args...> fmt,
+               const Args&... args)
+        : logger_(logger),
+          level_(level),
+          site_(fmt.site_id()),
+          timestamp_(std::chrono::system_clock::now()),
+          args_(args...) {}
+
+    // Lives in the awaiting coroutine's frame while it is suspended
+    LogAwaiter(const LogAwaiter&) = delete;
+    LogAwaiter& operator=(const LogAwaiter&) = delete;
+
+    bool await_ready() {
+        if (!logger_.should_log(level_) || !AsyncBackend::instance().is_running()) {
+            return true;
+        }
+        submit();
+        return pending_ == 0;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) {
+        retry_ = retry();
+        return retry_.start(caller);
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    // Queue to the workers still pending; updates pending_
+    void submit() {
+        AsyncBackend& backend = AsyncBackend::instance();
+        EpochGuard guard;
+        const AsyncLoggerState* state = logger_.state_.load(std::memory_order_acquire);
+        // Routes can change with the logger's sinks; keep the ones done
+        pending_ = std::apply(
+            [&](const Args&... args) {
+                return backend.try_submit(state, backend.route_mask(*state) & pending_, level_,
+                                          site_, timestamp_, args...);
+            },
+            args_);
+    }
+
+    detail::Task retry() {
+        AsyncBackend& backend = AsyncBackend::instance();
+        // A stopped backend drops the record; progress() no longer suspends
+        while (pending_ != 0 && backend.is_running()) {
+            auto worker = static_cast<std::size_t>(std::countr_zero(pending_));
+            // Re-register elsewhere as soon as this worker has the record
+            co_await backend.progress(worker, [this, worker] {
+                submit();
+                return (pending_ & (std::uint64_t{1} << worker)) == 0;
+            });
+        }
+    }
+
+    AsyncLogger& logger_;
+    LogLevel level_;
+    std::uint32_t site_;
+    std::chrono::system_clock::time_point timestamp_;
+    std::tuple<const Args&...> args_;
+    std::uint64_t pending_ = ~std::uint64_t{0};
+    detail::Task retry_;
+};
+
+/**
+ * @brief Awaiter returned by AsyncLogger::flush_wait_async().
+ *
+ * Holds the flush barrier requested by the call; while it is incomplete,
+ * waits for progress on each worker that has yet to complete it.
+ */
+class FlushAwaiter {
+public:
+    explicit FlushAwaiter(std::shared_ptr<FlushBarrier> barrier)
+        : barrier_(std::move(barrier)) {}
+    FlushAwaiter(const FlushAwaiter&) = delete;
+    FlushAwaiter& operator=(const FlushAwaiter&) = delete;
+
+    bool await_ready() const;
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller);
+    void await_resume() const noexcept {}
+
+private:
+    detail::Task wait();
+
+    std::shared_ptr<FlushBarrier> barrier_;
+    detail::Task wait_;
+};
+
 /**
  * @brief Initialize the global async backend.
  * 
@@ -99,6 +335,7 @@ void init_async(const AsyncConfig& config = AsyncConfig{});
  * @brief Shutdown the global async backend.
  * 
  * Flushes all pending log items and stops the background thread.
+ * Records logged once shutdown has begun are dropped.
  * Should be called before application exit.
  * @param timeout Maximum time to wait for pending items.
  */
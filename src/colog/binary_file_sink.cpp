@@ -0,0 +1,16 @@
+#include "binary_file_sink.h"
+
+namespace CoLog {
+
+BinaryFileSink::BinaryFileSink(const std::string& filename, bool append,
+                               std::size_t buffer_size, Compression compress_on_close)
+    : BufferedFileSink(filename, append, buffer_size, compress_on_close) {}
+
+void BinaryFileSink::write_record(const LogRecord& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    encoded_.clear();
+    encoder_.encode(record, encoded_);
+    append(encoded_);
+}
+
+}  // namespace CoLog
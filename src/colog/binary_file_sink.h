@@ -0,0 +1,36 @@
+#ifndef COLOG_BINARY_FILE_SINK_H
+#define COLOG_BINARY_FILE_SINK_H
+
+#include <string>
+
+#include "binary_format.h"
+#include "buffered_file_sink.h"
+
+namespace CoLog {
+
+// Buffered file sink that writes the compact binary encoding. It encodes
+// each record itself (writes_records()), under its lock and with its own
+// BinaryEncoder, so the logger's formatter is not used and the sink can
+// be shared by any number of sync or async loggers:
+//
+//   logger->add_sink(std::make_shared<CoLog::BinaryFileSink>("app.clog"));
+//
+// Decode the file with `colog-decode app.clog` (text) or `--json`.
+class BinaryFileSink : public BufferedFileSink {
+public:
+    explicit BinaryFileSink(const std::string& filename, bool append = true,
+                            std::size_t buffer_size = kDefaultBufferSize,
+                            Compression compress_on_close = Compression::None);
+
+    bool writes_records() const override { return true; }
+    void write_record(const LogRecord& record) override;
+
+private:
+    // Guarded by mutex_
+    BinaryEncoder encoder_;
+    std::string encoded_;
+};
+
+}  // namespace CoLog
+
+#endif  // COLOG_BINARY_FILE_SINK_H
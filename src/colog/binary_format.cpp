@@ -0,0 +1,286 @@
+#include "binary_format.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "format.h"
+
+namespace CoLog {
+
+namespace {
+
+void put_varint(std::string& dest, std::uint64_t value) {
+    while (value >= 0x80) {
+        dest.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    dest.push_back(static_cast<char>(value));
+}
+
+void put_string(std::string& dest, std::string_view text) {
+    put_varint(dest, text.size());
+    dest.append(text);
+}
+
+std::uint64_t zigzag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+// Bounds-checked reader; `ok` turns false once the input runs out
+struct Cursor {
+    std::string_view input;
+    bool ok = true;
+
+    std::uint8_t byte() {
+        if (input.empty()) {
+            ok = false;
+            return 0;
+        }
+        auto value = static_cast<std::uint8_t>(input.front());
+        input.remove_prefix(1);
+        return value;
+    }
+
+    std::uint64_t varint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            std::uint8_t b = byte();
+            if (!ok) {
+                return 0;
+            }
+            value |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Malformed varint in binary log");
+    }
+
+    std::string_view bytes(std::uint64_t size) {
+        if (!ok || size > input.size()) {
+            ok = false;
+            return {};
+        }
+        std::string_view value = input.substr(0, static_cast<std::size_t>(size));
+        input.remove_prefix(static_cast<std::size_t>(size));
+        return value;
+    }
+
+    std::string_view string() { return bytes(varint()); }
+};
+
+}  // namespace
+
+// --- BinaryEncoder ---
+
+std::size_t BinaryEncoder::SiteKeyHash::operator()(const SiteKey& key) const {
+    std::size_t hash = std::hash<const void*>{}(key.format);
+    hash = hash * 31 + std::hash<const void*>{}(key.file);
+    return hash * 31 + (static_cast<std::size_t>(key.line) << 8 | key.column);
+}
+
+void BinaryEncoder::encode(const LogRecord& record, std::string& dest) {
+    if (!session_started_) {
+        dest.push_back(static_cast<char>(binary::kHeader));
+        dest.append(binary::kMagic);
+        dest.push_back(static_cast<char>(binary::kVersion));
+        session_started_ = true;
+    }
+
+    // Definitions go in front of the record that first uses them
+    std::uint64_t logger = logger_id(record.logger_name, dest);
+    std::uint64_t site = site_id(record, dest);
+
+    auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        record.timestamp.time_since_epoch()).count();
+    dest.push_back(static_cast<char>(binary::kRecord));
+    put_varint(dest, zigzag(timestamp - last_timestamp_));
+    last_timestamp_ = timestamp;
+    dest.push_back(static_cast<char>(record.level));
+    put_varint(dest, logger);
+    put_varint(dest, site);
+    put_varint(dest, record.thread_id);
+
+    if (record.format != nullptr) {
+        put_varint(dest, record.format_args.size());
+        dest.append(reinterpret_cast<const char*>(record.format_args.data()),
+                    record.format_args.size());
+    } else {
+        // Already formatted: one string argument for the "{}" site
+        auto length = static_cast<std::uint32_t>(record.message.size());
+        put_varint(dest, 1 + sizeof(length) + length);
+        dest.push_back(static_cast<char>(ArgType::String));
+        dest.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        dest.append(record.message);
+    }
+}
+
+void BinaryEncoder::reset() {
+    session_started_ = false;
+    last_timestamp_ = 0;
+    loggers_.clear();
+    sites_.clear();
+    registry_sites_.clear();
+}
+
+std::uint64_t BinaryEncoder::logger_id(std::string_view name, std::string& dest) {
+    auto it = loggers_.find(name);
+    if (it != loggers_.end()) {
+        return it->second;
+    }
+    std::uint64_t id = loggers_.size();
+    loggers_.emplace(std::string(name), id);
+    dest.push_back(static_cast<char>(binary::kLogger));
+    put_varint(dest, id);
+    put_string(dest, name);
+    return id;
+}
+
+std::uint64_t BinaryEncoder::site_id(const LogRecord& record, std::string& dest) {
+    // Records from the async backend carry a registry id: a direct lookup
+    if (record.site_id != 0 && record.site_id < registry_sites_.size() &&
+        registry_sites_[record.site_id] != 0) {
+        return registry_sites_[record.site_id] - 1;
+    }
+
+    SiteKey key{record.format, record.location.file_name(), record.location.line(),
+                record.location.column()};
+    auto it = sites_.find(key);
+    std::uint64_t id = it != sites_.end() ? it->second : sites_.size();
+    if (record.site_id != 0) {
+        if (record.site_id >= registry_sites_.size()) {
+            registry_sites_.resize(record.site_id + 1, 0);
+        }
+        registry_sites_[record.site_id] = id + 1;
+    }
+    if (it != sites_.end()) {
+        return id;
+    }
+    sites_.emplace(key, id);
+    dest.push_back(static_cast<char>(binary::kSite));
+    put_varint(dest, id);
+    put_varint(dest, record.location.line());
+    put_string(dest, record.format != nullptr ? std::string_view(record.format) : "{}");
+    put_string(dest, record.location.file_name());
+    put_string(dest, record.location.function_name());
+    return id;
+}
+
+// --- BinaryLogDecoder ---
+
+void BinaryLogDecoder::feed(std::string_view data, const Handler& handler) {
+    std::string_view input = data;
+    if (!pending_.empty()) {
+        pending_.append(data);
+        input = pending_;
+    }
+
+    while (!input.empty() && decode_entry(input, handler)) {
+    }
+
+    // Keep the incomplete tail (copied: it may point into pending_ itself)
+    std::string rest(input);
+    pending_ = std::move(rest);
+}
+
+bool BinaryLogDecoder::decode_entry(std::string_view& input, const Handler& handler) {
+    Cursor in{input};
+    std::uint8_t tag = in.byte();
+
+    if (tag == binary::kHeader) {
+        std::string_view magic = in.bytes(binary::kMagic.size());
+        std::uint8_t version = in.byte();
+        if (!in.ok) {
+            return false;
+        }
+        if (magic != binary::kMagic || version != binary::kVersion) {
+            throw std::runtime_error("Unsupported binary log header");
+        }
+        session_started_ = true;
+        last_timestamp_ = 0;
+        loggers_.clear();
+        sites_.clear();
+        input = in.input;
+        return true;
+    }
+    if (!session_started_) {
+        throw std::runtime_error("Binary log does not start with a header");
+    }
+
+    switch (tag) {
+        case binary::kLogger: {
+            std::uint64_t id = in.varint();
+            std::string_view name = in.string();
+            if (!in.ok) {
+                return false;
+            }
+            if (id != loggers_.size()) {
+                throw std::runtime_error("Out of order logger id in binary log");
+            }
+            loggers_.emplace_back(name);
+            break;
+        }
+        case binary::kSite: {
+            std::uint64_t id = in.varint();
+            auto line = static_cast<std::uint32_t>(in.varint());
+            std::string_view format = in.string();
+            std::string_view file = in.string();
+            std::string_view function = in.string();
+            if (!in.ok) {
+                return false;
+            }
+            if (id != sites_.size()) {
+                throw std::runtime_error("Out of order site id in binary log");
+            }
+            sites_.push_back({std::string(format), std::string(file), std::string(function), line});
+            break;
+        }
+        case binary::kRecord: {
+            std::int64_t delta = unzigzag(in.varint());
+            std::uint8_t level = in.byte();
+            std::uint64_t logger = in.varint();
+            std::uint64_t site = in.varint();
+            std::uint64_t thread = in.varint();
+            std::string_view args = in.string();
+            if (!in.ok) {
+                return false;
+            }
+            if (logger >= loggers_.size() || site >= sites_.size() ||
+                level > static_cast<std::uint8_t>(LogLevel::Off)) {
+                throw std::runtime_error("Record refers to an undefined id in binary log");
+            }
+
+            last_timestamp_ += delta;
+            const Site& info = sites_[site];
+            BinaryRecord record;
+            record.timestamp = std::chrono::system_clock::time_point(
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                    std::chrono::nanoseconds(last_timestamp_)));
+            record.level = static_cast<LogLevel>(level);
+            record.thread_id = thread;
+            record.logger_name = loggers_[logger];
+            record.format = info.format;
+            record.file = info.file;
+            record.function = info.function;
+            record.line = info.line;
+            record.args = std::span<const std::byte>(
+                reinterpret_cast<const std::byte*>(args.data()), args.size());
+            handler(record);
+            break;
+        }
+        default:
+            if (!in.ok) {
+                return false;
+            }
+            throw std::runtime_error("Unknown entry in binary log");
+    }
+
+    input = in.input;
+    return true;
+}
+
+}  // namespace CoLog
@@ -0,0 +1,139 @@
+#ifndef COLOG_BINARY_FORMAT_H
+#define COLOG_BINARY_FORMAT_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "level.h"
+#include "record.h"
+
+namespace CoLog {
+
+// Compact binary log encoding, written by BinaryEncoder and read back by
+// BinaryLogDecoder (and the colog-decode tool).
+//
+// A stream is a sequence of entries, each starting with a one-byte tag:
+//   Header  "CLGB" and a version byte. Starts a session: ids and the
+//           timestamp base reset, so appended sessions decode correctly.
+//   Logger  id, name                                (first use of a name)
+//   Site    id, line, format, file, function        (first use of a call site)
+//   Record  timestamp delta in ns (zigzag), level, logger id, site id,
+//           thread id, argument bytes
+// Integers are LEB128 varints; strings and argument bytes are a varint
+// length followed by the data. Arguments use the format.h encoding (host
+// byte order). Messages that were formatted before reaching the formatter
+// are stored against a "{}" site with one string argument.
+namespace binary {
+
+constexpr std::uint8_t kHeader = 0xC1;
+constexpr std::uint8_t kLogger = 0x01;
+constexpr std::uint8_t kSite = 0x02;
+constexpr std::uint8_t kRecord = 0x03;
+
+constexpr std::string_view kMagic = "CLGB";
+constexpr std::uint8_t kVersion = 1;
+
+}  // namespace binary
+
+// Encodes records instead of rendering text, so the async backend skips
+// message formatting entirely. Logger names and call sites are interned:
+// each is written once, then referred to by a small id, and timestamps
+// are deltas from the previous record.
+//
+// That state describes one output stream, so an encoder belongs to one
+// sink and must see records in the order they are written. BinaryFileSink
+// owns one and encodes under its lock; the encoder itself is not
+// thread-safe.
+class BinaryEncoder {
+public:
+    // Append the entries for `record` (with any definitions it needs first)
+    void encode(const LogRecord& record, std::string& dest);
+
+    // Forget interned ids; the next record starts a new session
+    void reset();
+
+private:
+    struct SiteKey {
+        const char* format;
+        const char* file;
+        std::uint32_t line;
+        std::uint32_t column;
+
+        bool operator==(const SiteKey&) const = default;
+    };
+
+    struct SiteKeyHash {
+        std::size_t operator()(const SiteKey& key) const;
+    };
+
+    struct NameHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view name) const {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+
+    std::uint64_t logger_id(std::string_view name, std::string& dest);
+    std::uint64_t site_id(const LogRecord& record, std::string& dest);
+
+    bool session_started_ = false;
+    std::int64_t last_timestamp_ = 0;
+    std::unordered_map<std::string, std::uint64_t, NameHash, std::equal_to<>> loggers_;
+    std::unordered_map<SiteKey, std::uint64_t, SiteKeyHash> sites_;
+    std::vector<std::uint64_t> registry_sites_;  // SiteRegistry id -> stream id + 1
+};
+
+// One decoded record. Views are valid until the handler returns.
+struct BinaryRecord {
+    std::chrono::system_clock::time_point timestamp;
+    LogLevel level = LogLevel::Info;
+    std::uint64_t thread_id = 0;
+    std::string_view logger_name;
+    std::string_view format;
+    std::string_view file;
+    std::string_view function;
+    std::uint32_t line = 0;
+    std::span<const std::byte> args;  // For vformat_to(out, format, args)
+};
+
+// Incremental decoder for the binary encoding. Input may be fed in chunks
+// of any size; entries split across chunks are completed by later calls.
+class BinaryLogDecoder {
+public:
+    using Handler = std::function<void(const BinaryRecord&)>;
+
+    // Decode as much of `data` as possible, calling `handler` per record.
+    // Throws std::runtime_error on malformed input.
+    void feed(std::string_view data, const Handler& handler);
+
+    // True if the input so far ends in the middle of an entry
+    bool has_partial() const { return !pending_.empty(); }
+
+private:
+    struct Site {
+        std::string format;
+        std::string file;
+        std::string function;
+        std::uint32_t line;
+    };
+
+    // Returns false (consuming nothing) if `input` holds no complete entry
+    bool decode_entry(std::string_view& input, const Handler& handler);
+
+    std::string pending_;
+    bool session_started_ = false;
+    std::int64_t last_timestamp_ = 0;
+    std::vector<std::string> loggers_;
+    std::vector<Site> sites_;
+};
+
+}  // namespace CoLog
+
+#endif  // COLOG_BINARY_FORMAT_H
@@ -0,0 +1,109 @@
+#include "buffered_file_sink.h"
+
+#include <cstring>
+
+#include "async/async_backend.h"
+
+namespace CoLog {
+
+BufferedFileSink::BufferedFileSink(const std::string& filename, bool append,
+                                   std::size_t buffer_size, Compression compress_on_close)
+    : writer_(filename, append),
+      buffer_(new char[buffer_size > 0 ? buffer_size : 1]),
+      capacity_(buffer_size > 0 ? buffer_size : 1),
+      compress_on_close_(compress_on_close) {
+    require_compression(compress_on_close_, filename);
+}
+
+BufferedFileSink::~BufferedFileSink() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    try {
+        write_buffer();
+    } catch (...) {
+        // Nothing sensible to do with a write error during destruction
+    }
+    if (compress_on_close_ != Compression::None) {
+        std::string filename = writer_.filename();
+        writer_.close();
+        AsyncBackend::compress_closed_file(std::move(filename), compress_on_close_);
+    }
+}
+
+void BufferedFileSink::write(std::string_view message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(message);
+}
+
+void BufferedFileSink::append(std::string_view message) {
+    if (message.size() <= capacity_ - size_) {
+        std::memcpy(buffer_.get() + size_, message.data(), message.size());
+        size_ += message.size();
+        if (size_ == capacity_) {
+            write_buffer();
+        }
+        return;
+    }
+
+    if (message.size() >= capacity_) {
+        // Too big to buffer: one writev() for the pending bytes and the message
+        std::string_view pending(buffer_.get(), size_);
+        size_ = 0;
+        writer_.write(pending, message);
+        return;
+    }
+
+    write_buffer();
+    std::memcpy(buffer_.get(), message.data(), message.size());
+    size_ = message.size();
+}
+
+void BufferedFileSink::write_batch(std::span<const std::string_view> messages) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t total = 0;
+    for (std::string_view message : messages) {
+        total += message.size();
+    }
+
+    if (total <= capacity_ - size_) {
+        for (std::string_view message : messages) {
+            std::memcpy(buffer_.get() + size_, message.data(), message.size());
+            size_ += message.size();
+        }
+        if (size_ == capacity_) {
+            write_buffer();
+        }
+        return;
+    }
+
+    // Does not fit: one writev() for the pending bytes and the whole batch
+    std::string_view pending(buffer_.get(), size_);
+    size_ = 0;
+    writer_.write(pending, messages);
+}
+
+void BufferedFileSink::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_buffer();
+}
+
+void BufferedFileSink::on_batch_end() {
+    flush();
+}
+
+bool BufferedFileSink::is_open() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return writer_.is_open();
+}
+
+void BufferedFileSink::write_buffer() {
+    if (size_ == 0) {
+        return;
+    }
+    // Drop the data even if the write throws, so one failure does not
+    // wedge every later message behind a full buffer
+    std::string_view pending(buffer_.get(), size_);
+    size_ = 0;
+    writer_.write(pending);
+}
+
+}  // namespace CoLog
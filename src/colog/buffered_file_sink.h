@@ -0,0 +1,58 @@
+#ifndef COLOG_BUFFERED_FILE_SINK_H
+#define COLOG_BUFFERED_FILE_SINK_H
+
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+
+#include "compression.h"
+#include "file_writer.h"
+#include "sink.h"
+
+namespace CoLog {
+
+// File sink that accumulates messages in a large userspace buffer and
+// hands it to the kernel with raw write()/writev() calls, bypassing
+// iostreams entirely. The buffer is written out when it fills up, at the
+// end of each async backend batch, on flush() and on destruction.
+// Messages larger than the free space go out together with the buffered
+// data in a single writev(), and so does a write_batch() that does not fit.
+// With `compress_on_close` set, the file is handed to the AsyncBackend's
+// FileCompressor once the sink has closed it.
+class BufferedFileSink : public ISink {
+public:
+    static constexpr std::size_t kDefaultBufferSize = 256 * 1024;
+
+    explicit BufferedFileSink(const std::string& filename, bool append = true,
+                              std::size_t buffer_size = kDefaultBufferSize,
+                              Compression compress_on_close = Compression::None);
+    ~BufferedFileSink() override;
+
+    void write(std::string_view message) override;
+    void write_batch(std::span<const std::string_view> messages) override;
+    void flush() override;
+    void on_batch_end() override;
+
+    bool is_open() const;
+    std::size_t buffer_size() const { return capacity_; }
+
+protected:
+    // write() without the lock; the caller holds mutex_
+    void append(std::string_view message);
+
+    mutable std::mutex mutex_;
+
+private:
+    void write_buffer();
+
+    FileWriter writer_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t capacity_;
+    std::size_t size_ = 0;
+    Compression compress_on_close_;
+};
+
+}  // namespace CoLog
+
+#endif  // COLOG_BUFFERED_FILE_SINK_H
@@ -8,13 +8,24 @@
 #include "record.h"
 
 // Formatter
+#include "format.h"
+#include "log_site.h"
 #include "formatter.h"
 #include "pattern_formatter.h"
+#include "binary_format.h"
 
 // Sinks
 #include "sink.h"
 #include "console_sink.h"
 #include "file_sink.h"
+#include "buffered_file_sink.h"
+#include "binary_file_sink.h"
+#include "rotating_file_sink.h"
+#include "compressed_file_sink.h"
+#ifndef _WIN32
+#include "mmap_file_sink.h"
+#include "uring_file_sink.h"
+#endif
 #include "null_sink.h"
 
 // Synchronous Logger
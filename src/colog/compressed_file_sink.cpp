@@ -0,0 +1,359 @@
+#include "compressed_file_sink.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+#include "compression.h"
+
+namespace CoLog {
+
+namespace {
+
+// Seek index: an LZ4 skippable frame holding (frame size, text size) per
+// block, followed by the block count and kIndexMagic
+constexpr std::uint32_t kSkippableMagic = 0x184D2A5C;
+constexpr std::uint32_t kSkippableMask = 0xFFFFFFF0;
+constexpr std::uint32_t kIndexMagic = 0x58494C43;  // "CLIX"
+
+void put_le32(char* out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+std::uint32_t get_le32(const char* in) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+}  // namespace
+
+// --- CompressedFileSink ---
+
+CompressedFileSink::CompressedFileSink(const std::string& filename, bool append,
+                                       std::size_t block_size,
+                                       std::chrono::milliseconds max_delay)
+    : block_size_(std::clamp<std::size_t>(block_size, 1, detail::kLz4MaxBlockSize)),
+      max_delay_(max_delay),
+      block_(block_size_),
+      frame_(detail::lz4_frame_bound(block_size_)) {
+    std::error_code ec;
+    if (append && std::filesystem::file_size(filename, ec) > 0 && !ec) {
+        // Resume after the last complete block, dropping the old index
+        CompressedLogReader reader(filename);
+        if (reader.data_end() == 0 && !reader.starts_with_frame()) {
+            throw std::runtime_error("Not a compressed log file: " + filename);
+        }
+        index_ = reader.blocks();
+        file_end_ = reader.data_end();
+        if (!index_.empty()) {
+            raw_end_ = index_.back().raw_offset + index_.back().raw_size;
+        }
+        std::filesystem::resize_file(filename, file_end_);
+    }
+    writer_.open(filename, append);
+}
+
+CompressedFileSink::~CompressedFileSink() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    try {
+        write_block();
+        write_index();
+    } catch (...) {
+        // Nothing sensible to do with a write error during destruction
+    }
+}
+
+void CompressedFileSink::write(std::string_view message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(message);
+}
+
+void CompressedFileSink::write_batch(std::span<const std::string_view> messages) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::string_view message : messages) {
+        append(message);
+    }
+}
+
+void CompressedFileSink::append(std::string_view message) {
+    // Keep messages whole within a block where they fit
+    if (block_used_ > 0 && message.size() > block_size_ - block_used_) {
+        write_block();
+    }
+    if (block_used_ == 0 && !message.empty()) {
+        pending_since_ = std::chrono::steady_clock::now();
+    }
+    while (!message.empty()) {
+        std::size_t n = std::min(message.size(), block_size_ - block_used_);
+        std::memcpy(block_.data() + block_used_, message.data(), n);
+        block_used_ += n;
+        message.remove_prefix(n);
+        if (block_used_ == block_size_) {
+            write_block();
+        }
+    }
+}
+
+void CompressedFileSink::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_block();
+}
+
+void CompressedFileSink::on_batch_end() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Small blocks compress poorly; only cut one early once data has
+    // waited long enough that readers tailing the file would notice
+    if (block_used_ > 0 && std::chrono::steady_clock::now() - pending_since_ >= max_delay_) {
+        write_block();
+    }
+}
+
+std::chrono::steady_clock::time_point CompressedFileSink::batch_end_deadline() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (block_used_ == 0) {
+        return {};
+    }
+    return pending_since_ + max_delay_;
+}
+
+std::uint64_t CompressedFileSink::raw_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return raw_end_ + block_used_;
+}
+
+std::uint64_t CompressedFileSink::compressed_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return file_end_;
+}
+
+void CompressedFileSink::write_block() {
+    if (block_used_ == 0) {
+        return;
+    }
+    std::size_t raw_size = block_used_;
+    std::size_t size = detail::lz4_write_frame(block_.data(), raw_size, frame_.data());
+    // Drop the data even if the write throws, so one failure does not
+    // wedge every later message behind a full block
+    block_used_ = 0;
+    pending_since_ = {};
+    writer_.write(std::string_view(frame_.data(), size));
+
+    index_.push_back({file_end_, size, raw_end_, raw_size});
+    file_end_ += size;
+    raw_end_ += raw_size;
+}
+
+void CompressedFileSink::write_index() {
+    if (index_.empty()) {
+        return;
+    }
+    std::size_t content = index_.size() * 8 + 8;
+    std::vector<char> frame(8 + content);
+    put_le32(frame.data(), kSkippableMagic);
+    put_le32(frame.data() + 4, static_cast<std::uint32_t>(content));
+    char* out = frame.data() + 8;
+    for (const CompressedBlock& block : index_) {
+        put_le32(out, static_cast<std::uint32_t>(block.size));
+        put_le32(out + 4, static_cast<std::uint32_t>(block.raw_size));
+        out += 8;
+    }
+    put_le32(out, static_cast<std::uint32_t>(index_.size()));
+    put_le32(out + 4, kIndexMagic);
+    writer_.write(std::string_view(frame.data(), frame.size()));
+}
+
+// --- CompressedLogReader ---
+
+CompressedLogReader::CompressedLogReader(const std::string& filename)
+    : file_(filename, std::ios::binary) {
+    if (!file_) {
+        throw std::runtime_error("Failed to open compressed log " + filename);
+    }
+    std::error_code ec;
+    std::uint64_t file_size = std::filesystem::file_size(filename, ec);
+    if (ec) {
+        throw std::runtime_error("Failed to stat compressed log " + filename);
+    }
+    if (!load_index(file_size)) {
+        scan_frames(file_size);
+    }
+}
+
+std::size_t CompressedLogReader::find_block(std::uint64_t raw_offset) const {
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), raw_offset,
+                               [](std::uint64_t offset, const CompressedBlock& block) {
+                                   return offset < block.raw_offset + block.raw_size;
+                               });
+    return static_cast<std::size_t>(it - blocks_.begin());
+}
+
+std::string CompressedLogReader::read_block(std::size_t index) {
+    const CompressedBlock& block = blocks_.at(index);
+    std::vector<char> frame(block.size);
+    if (!read_at(block.offset, frame.data(), frame.size())) {
+        throw std::runtime_error("Failed to read compressed block");
+    }
+
+    detail::Lz4FrameHeader header = detail::lz4_parse_frame_header(frame.data(), frame.size());
+    if (!header.valid) {
+        throw std::runtime_error("Corrupt compressed block header");
+    }
+
+    std::string text;
+    text.reserve(block.raw_size);
+    std::size_t pos = header.header_size;
+    while (pos + 4 <= frame.size()) {
+        bool uncompressed = false;
+        std::uint32_t size = detail::lz4_block_size(frame.data() + pos, &uncompressed);
+        pos += 4;
+        if (size == 0) {
+            return text;  // End mark
+        }
+        if (size > frame.size() - pos) {
+            break;
+        }
+        if (uncompressed) {
+            text.append(frame.data() + pos, size);
+        } else {
+            std::size_t start = text.size();
+            text.resize(start + detail::kLz4MaxBlockSize);
+            std::size_t produced = detail::lz4_decompress_block(
+                frame.data() + pos, size, text.data() + start, detail::kLz4MaxBlockSize);
+            text.resize(start + produced);
+        }
+        pos += size + (header.block_checksum ? 4 : 0);
+    }
+    throw std::runtime_error("Truncated compressed block");
+}
+
+bool CompressedLogReader::starts_with_frame() {
+    char magic[4];
+    return read_at(0, magic, sizeof(magic)) && get_le32(magic) == detail::kLz4FrameMagic;
+}
+
+bool CompressedLogReader::load_index(std::uint64_t file_size) {
+    char footer[8];
+    if (file_size < 16 || !read_at(file_size - 8, footer, sizeof(footer)) ||
+        get_le32(footer + 4) != kIndexMagic) {
+        return false;
+    }
+    std::uint64_t content = std::uint64_t{get_le32(footer)} * 8 + 8;
+    if (content + 8 > file_size) {
+        return false;
+    }
+    std::uint64_t start = file_size - content - 8;
+    std::vector<char> frame(content + 8);
+    if (!read_at(start, frame.data(), frame.size()) || get_le32(frame.data()) != kSkippableMagic ||
+        get_le32(frame.data() + 4) != content) {
+        return false;
+    }
+
+    std::vector<CompressedBlock> blocks;
+    std::uint64_t offset = 0;
+    std::uint64_t raw_offset = 0;
+    for (const char* entry = frame.data() + 8; entry < frame.data() + 8 + content - 8; entry += 8) {
+        CompressedBlock block{offset, get_le32(entry), raw_offset, get_le32(entry + 4)};
+        offset += block.size;
+        raw_offset += block.raw_size;
+        blocks.push_back(block);
+    }
+    if (offset != start) {
+        return false;  // Not ours, or not written by a single sink
+    }
+
+    blocks_ = std::move(blocks);
+    indexed_ = true;
+    data_end_ = start;
+    return true;
+}
+
+void CompressedLogReader::scan_frames(std::uint64_t file_size) {
+    std::uint64_t pos = 0;
+    std::uint64_t raw_offset = 0;
+    char header_bytes[detail::kLz4MaxFrameHeader];
+    std::vector<char> scratch;
+    std::string text;
+
+    while (pos + 8 <= file_size) {
+        std::size_t available = static_cast<std::size_t>(
+            std::min<std::uint64_t>(sizeof(header_bytes), file_size - pos));
+        if (!read_at(pos, header_bytes, available)) {
+            break;
+        }
+
+        if ((get_le32(header_bytes) & kSkippableMask) == (kSkippableMagic & kSkippableMask)) {
+            // Skippable frame (such as a stale index); a torn one ends the data
+            std::uint64_t end = pos + 8 + std::uint64_t{get_le32(header_bytes + 4)};
+            if (end > file_size) {
+                break;
+            }
+            pos = end;
+            data_end_ = pos;
+            continue;
+        }
+
+        detail::Lz4FrameHeader header = detail::lz4_parse_frame_header(header_bytes, available);
+        if (!header.valid) {
+            break;
+        }
+
+        // Walk the block size fields to find the end of the frame
+        std::uint64_t cursor = pos + header.header_size;
+        std::uint64_t raw_size = 0;
+        bool complete = false;
+        char size_field[4];
+        while (cursor + 4 <= file_size && read_at(cursor, size_field, 4)) {
+            bool uncompressed = false;
+            std::uint32_t size = detail::lz4_block_size(size_field, &uncompressed);
+            cursor += 4;
+            if (size == 0) {
+                cursor += header.content_checksum ? 4 : 0;
+                complete = cursor <= file_size;
+                break;
+            }
+            if (cursor + size > file_size) {
+                break;
+            }
+            if (uncompressed) {
+                raw_size += size;
+            } else if (header.content_size == 0) {
+                // No recorded size: decompress to count
+                scratch.resize(size);
+                text.resize(detail::kLz4MaxBlockSize);
+                if (!read_at(cursor, scratch.data(), size)) {
+                    break;
+                }
+                raw_size += detail::lz4_decompress_block(scratch.data(), size, text.data(),
+                                                         text.size());
+            }
+            cursor += size + (header.block_checksum ? 4 : 0);
+        }
+        if (!complete) {
+            break;  // Torn final frame
+        }
+
+        if (header.content_size != 0) {
+            raw_size = header.content_size;
+        }
+        blocks_.push_back({pos, cursor - pos, raw_offset, raw_size});
+        raw_offset += raw_size;
+        pos = cursor;
+        data_end_ = pos;
+    }
+}
+
+bool CompressedLogReader::read_at(std::uint64_t offset, char* data, std::size_t size) {
+    file_.clear();
+    file_.seekg(static_cast<std::streamoff>(offset));
+    file_.read(data, static_cast<std::streamsize>(size));
+    return static_cast<std::size_t>(file_.gcount()) == size;
+}
+
+}  // namespace CoLog
@@ -0,0 +1,127 @@
+#ifndef COLOG_COMPRESSED_FILE_SINK_H
+#define COLOG_COMPRESSED_FILE_SINK_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "file_writer.h"
+#include "sink.h"
+
+namespace CoLog {
+
+// One independently decompressible block of a compressed log file
+struct CompressedBlock {
+    std::uint64_t offset = 0;      // Position of the frame in the file
+    std::uint64_t size = 0;        // Frame size in the file
+    std::uint64_t raw_offset = 0;  // Position of its text in the uncompressed log
+    std::uint64_t raw_size = 0;    // Uncompressed size
+};
+
+// File sink that compresses its output while writing, for hosts where disk
+// bandwidth rather than CPU limits logging.
+//
+// Messages are collected into blocks of up to `block_size` bytes (split
+// only at message boundaries unless a single message is larger). Each
+// block is written as a complete LZ4 frame, so the file is a valid .lz4
+// stream at every block boundary: `lz4 -dc` decodes it, and it can be
+// tailed block by block while still being written. A block is written
+// when full, on flush(), on destruction and, under the async backend, once
+// its oldest message is `max_delay` old: at the end of the batch that finds
+// it so, or by the idle worker at that moment (batch_end_deadline()). With
+// a synchronous Logger only the first three apply.
+//
+// On destruction a seek index (frame and text sizes per block) is appended
+// as an LZ4 skippable frame, which decoders ignore. CompressedLogReader
+// uses it to find blocks without scanning, and falls back to walking the
+// frame headers when the file was not closed cleanly. Appending to an
+// existing file drops its index (and any torn final block) first.
+class CompressedFileSink : public ISink {
+public:
+    static constexpr std::size_t kDefaultBlockSize = 256 * 1024;
+    static constexpr std::chrono::milliseconds kDefaultMaxDelay{1000};
+
+    explicit CompressedFileSink(const std::string& filename, bool append = true,
+                                std::size_t block_size = kDefaultBlockSize,
+                                std::chrono::milliseconds max_delay = kDefaultMaxDelay);
+    ~CompressedFileSink() override;
+
+    // Non-copyable
+    CompressedFileSink(const CompressedFileSink&) = delete;
+    CompressedFileSink& operator=(const CompressedFileSink&) = delete;
+
+    void write(std::string_view message) override;
+    void write_batch(std::span<const std::string_view> messages) override;
+    void flush() override;
+    void on_batch_end() override;
+    std::chrono::steady_clock::time_point batch_end_deadline() const override;
+
+    // Uncompressed and written (compressed) byte totals, for ratio reporting
+    std::uint64_t raw_bytes() const;
+    std::uint64_t compressed_bytes() const;
+
+private:
+    // write() without the lock; the caller holds mutex_
+    void append(std::string_view message);
+
+    void write_block();
+    void write_index();
+
+    FileWriter writer_;
+    std::size_t block_size_;
+    std::chrono::milliseconds max_delay_;
+
+    std::vector<char> block_;
+    std::size_t block_used_ = 0;
+    std::vector<char> frame_;  // Scratch space for the compressed frame
+    std::chrono::steady_clock::time_point pending_since_{};  // First message of the block
+
+    std::vector<CompressedBlock> index_;
+    std::uint64_t file_end_ = 0;
+    std::uint64_t raw_end_ = 0;
+    mutable std::mutex mutex_;
+};
+
+// Random access to a file written by CompressedFileSink (or any LZ4 frame
+// stream): lists its blocks and decompresses them individually.
+class CompressedLogReader {
+public:
+    // Throws std::runtime_error if the file cannot be opened
+    explicit CompressedLogReader(const std::string& filename);
+
+    const std::vector<CompressedBlock>& blocks() const { return blocks_; }
+
+    // True when the blocks came from a seek index rather than a scan
+    bool indexed() const { return indexed_; }
+
+    // End of the last complete block (where an appending writer resumes)
+    std::uint64_t data_end() const { return data_end_; }
+
+    // Index of the block holding the given uncompressed offset, or
+    // blocks().size() if it is past the end
+    std::size_t find_block(std::uint64_t raw_offset) const;
+
+    // Decompressed text of one block
+    std::string read_block(std::size_t index);
+
+    // Whether the file begins with an LZ4 frame magic (complete or not)
+    bool starts_with_frame();
+
+private:
+    bool load_index(std::uint64_t file_size);
+    void scan_frames(std::uint64_t file_size);
+    bool read_at(std::uint64_t offset, char* data, std::size_t size);
+
+    std::ifstream file_;
+    std::vector<CompressedBlock> blocks_;
+    bool indexed_ = false;
+    std::uint64_t data_end_ = 0;
+};
+
+}  // namespace CoLog
+
+#endif  // COLOG_COMPRESSED_FILE_SINK_H
@@ -0,0 +1,490 @@
+#include "compression.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#ifdef COLOG_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#include "file_writer.h"
+
+namespace CoLog {
+
+namespace {
+
+constexpr std::size_t kChunkSize = 256 * 1024;
+
+// --- LZ4 block format ---
+
+constexpr std::size_t kMinMatch = 4;
+constexpr std::size_t kLastLiterals = 5;   // A block always ends with this many literals
+constexpr std::size_t kMatchLimit = 12;    // No match may start closer than this to the end
+constexpr std::size_t kMaxOffset = 65535;
+constexpr int kHashBits = 14;
+
+inline std::uint32_t read32(const char* p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline std::uint32_t hash4(std::uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - kHashBits);
+}
+
+// Length fields above 15 continue in 255-valued bytes
+inline char* write_length(char* out, std::size_t length) {
+    while (length >= 255) {
+        *out++ = static_cast<char>(255);
+        length -= 255;
+    }
+    *out++ = static_cast<char>(length);
+    return out;
+}
+
+char* write_sequence(char* out, const char* literals, std::size_t literal_length,
+                     std::size_t offset, std::size_t match_length) {
+    char* token = out++;
+    unsigned high = literal_length >= 15 ? 15 : static_cast<unsigned>(literal_length);
+    if (literal_length >= 15) {
+        out = write_length(out, literal_length - 15);
+    }
+    std::memcpy(out, literals, literal_length);
+    out += literal_length;
+
+    if (match_length == 0) {
+        // Final literals-only sequence
+        *token = static_cast<char>(high << 4);
+        return out;
+    }
+
+    *out++ = static_cast<char>(offset & 0xff);
+    *out++ = static_cast<char>(offset >> 8);
+    std::size_t extra = match_length - kMinMatch;
+    unsigned low = extra >= 15 ? 15 : static_cast<unsigned>(extra);
+    if (extra >= 15) {
+        out = write_length(out, extra - 15);
+    }
+    *token = static_cast<char>((high << 4) | low);
+    return out;
+}
+
+// --- LZ4 frame format ---
+
+constexpr std::uint32_t kLz4Magic = detail::kLz4FrameMagic;
+constexpr std::uint32_t kLz4Uncompressed = 0x80000000;
+constexpr unsigned char kLz4Version = 0x40;
+constexpr unsigned char kLz4Independent = 0x20;
+constexpr unsigned char kLz4BlockChecksum = 0x10;
+constexpr unsigned char kLz4ContentSize = 0x08;
+constexpr unsigned char kLz4ContentChecksum = 0x04;
+constexpr unsigned char kLz4DictId = 0x01;
+
+// xxHash32 of a short (< 16 byte) input, used for the frame header checksum
+std::uint32_t xxh32_short(const unsigned char* data, std::size_t size) {
+    constexpr std::uint32_t kPrime1 = 2654435761U;
+    constexpr std::uint32_t kPrime2 = 2246822519U;
+    constexpr std::uint32_t kPrime3 = 3266489917U;
+    constexpr std::uint32_t kPrime4 = 668265263U;
+    constexpr std::uint32_t kPrime5 = 374761393U;
+    auto rotl = [](std::uint32_t x, int r) { return (x << r) | (x >> (32 - r)); };
+
+    std::uint32_t hash = kPrime5 + static_cast<std::uint32_t>(size);
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        std::uint32_t lane;
+        std::memcpy(&lane, data + i, 4);
+        hash = rotl(hash + lane * kPrime3, 17) * kPrime4;
+    }
+    for (; i < size; ++i) {
+        hash = rotl(hash + data[i] * kPrime5, 11) * kPrime1;
+    }
+    hash ^= hash >> 15;
+    hash *= kPrime2;
+    hash ^= hash >> 13;
+    hash *= kPrime3;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+void put_le32(char* out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+std::uint32_t get_le32(const char* in) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+// Block maximum size code for the BD byte: 4 = 64 KiB ... 7 = 4 MiB
+unsigned char block_max_code(std::size_t size) {
+    unsigned char code = 4;
+    while (code < 7 && (std::size_t{1} << (8 + 2 * code)) < size) {
+        ++code;
+    }
+    return code;
+}
+
+// Writes a frame header with independent blocks and no checksums;
+// `content_size` is recorded when nonzero. Returns the header size.
+std::size_t write_frame_header(char* out, std::size_t block_max, std::uint64_t content_size) {
+    unsigned char descriptor[10] = {};
+    std::size_t length = 2;
+    descriptor[0] = kLz4Version | kLz4Independent;
+    descriptor[1] = static_cast<unsigned char>(block_max_code(block_max) << 4);
+    if (content_size > 0) {
+        descriptor[0] |= kLz4ContentSize;
+        for (int i = 0; i < 8; ++i) {
+            descriptor[2 + i] = static_cast<unsigned char>((content_size >> (8 * i)) & 0xff);
+        }
+        length += 8;
+    }
+
+    put_le32(out, kLz4Magic);
+    std::memcpy(out + 4, descriptor, length);
+    out[4 + length] = static_cast<char>((xxh32_short(descriptor, length) >> 8) & 0xff);
+    return 4 + length + 1;
+}
+
+// Writes one data block (compressed unless that would not save space).
+// `dest` must hold 4 + lz4_block_bound(size) bytes.
+std::size_t write_data_block(const char* source, std::size_t size, char* dest) {
+    std::size_t compressed = detail::lz4_compress_block(source, size, dest + 4);
+    if (compressed < size) {
+        put_le32(dest, static_cast<std::uint32_t>(compressed));
+        return 4 + compressed;
+    }
+    put_le32(dest, static_cast<std::uint32_t>(size) | kLz4Uncompressed);
+    std::memcpy(dest + 4, source, size);
+    return 4 + size;
+}
+
+// Reads the source in chunks and hands each to `consume`
+template <typename Consume>
+bool for_each_chunk(std::ifstream& in, const CompressionProgress& progress, Consume consume) {
+    std::vector<char> chunk(kChunkSize);
+    while (in) {
+        in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        auto got = static_cast<std::size_t>(in.gcount());
+        if (got == 0) {
+            break;
+        }
+        consume(chunk.data(), got);
+        if (progress && !progress(got)) {
+            return false;
+        }
+    }
+    if (in.bad()) {
+        throw std::runtime_error("Failed to read log file for compression");
+    }
+    return true;
+}
+
+bool compress_lz4(std::ifstream& in, FileWriter& out, const CompressionProgress& progress) {
+    char header[detail::kLz4MaxFrameHeader];
+    out.write(std::string_view(header, write_frame_header(header, kChunkSize, 0)));
+
+    std::vector<char> block(4 + detail::lz4_block_bound(kChunkSize));
+    bool completed = for_each_chunk(in, progress, [&](const char* data, std::size_t size) {
+        out.write(std::string_view(block.data(), write_data_block(data, size, block.data())));
+    });
+
+    char end_mark[4] = {};
+    out.write(std::string_view(end_mark, sizeof(end_mark)));
+    return completed;
+}
+
+#ifdef COLOG_HAS_ZLIB
+bool compress_gzip(std::ifstream& in, FileWriter& out, const CompressionProgress& progress) {
+    z_stream stream{};
+    // 15 window bits + 16 selects the gzip wrapper
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("Failed to initialise zlib");
+    }
+    std::unique_ptr<z_stream, int (*)(z_stream*)> guard(&stream, deflateEnd);
+
+    std::vector<char> buffer(kChunkSize);
+    auto pump = [&](int flush) {
+        do {
+            stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+            stream.avail_out = static_cast<uInt>(buffer.size());
+            int result = deflate(&stream, flush);
+            if (result == Z_STREAM_ERROR) {
+                throw std::runtime_error("zlib deflate failed");
+            }
+            out.write(std::string_view(buffer.data(), buffer.size() - stream.avail_out));
+        } while (stream.avail_out == 0);
+    };
+
+    bool completed = for_each_chunk(in, progress, [&](const char* data, std::size_t size) {
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        stream.avail_in = static_cast<uInt>(size);
+        pump(Z_NO_FLUSH);
+    });
+    pump(Z_FINISH);
+    return completed;
+}
+#endif
+
+}  // namespace
+
+namespace detail {
+
+std::size_t lz4_compress_block(const char* source, std::size_t size, char* dest) {
+    char* out = dest;
+    std::size_t anchor = 0;
+
+    if (size > kMatchLimit) {
+        std::vector<std::uint32_t> table(std::size_t{1} << kHashBits, 0);
+        const std::size_t match_end = size - kLastLiterals;
+        std::size_t pos = 1;
+        table[hash4(read32(source))] = 0;
+
+        while (pos < size - kMatchLimit) {
+            std::uint32_t sequence = read32(source + pos);
+            std::uint32_t& slot = table[hash4(sequence)];
+            std::size_t candidate = slot;
+            slot = static_cast<std::uint32_t>(pos);
+
+            if (pos - candidate > kMaxOffset || read32(source + candidate) != sequence) {
+                // Skip faster through data that keeps missing
+                pos += 1 + ((pos - anchor) >> 6);
+                continue;
+            }
+
+            // Extend backwards over literals, then forwards
+            while (pos > anchor && candidate > 0 && source[pos - 1] == source[candidate - 1]) {
+                --pos;
+                --candidate;
+            }
+            std::size_t length = kMinMatch;
+            while (pos + length < match_end && source[pos + length] == source[candidate + length]) {
+                ++length;
+            }
+
+            out = write_sequence(out, source + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+            if (pos < size - kMatchLimit) {
+                table[hash4(read32(source + pos - 2))] = static_cast<std::uint32_t>(pos - 2);
+            }
+        }
+    }
+
+    out = write_sequence(out, source + anchor, size - anchor, 0, 0);
+    return static_cast<std::size_t>(out - dest);
+}
+
+std::size_t lz4_decompress_block(const char* source, std::size_t size, char* dest,
+                                 std::size_t capacity) {
+    auto corrupt = [] { throw std::runtime_error("Corrupt LZ4 block"); };
+    const auto* in = reinterpret_cast<const unsigned char*>(source);
+    const auto* in_end = in + size;
+    char* out = dest;
+    char* out_end = dest + capacity;
+
+    auto read_length = [&](std::size_t length) {
+        if (length == 15) {
+            unsigned char byte;
+            do {
+                if (in == in_end) {
+                    corrupt();
+                }
+                byte = *in++;
+                length += byte;
+            } while (byte == 255);
+        }
+        return length;
+    };
+
+    while (in < in_end) {
+        unsigned token = *in++;
+        std::size_t literals = read_length(token >> 4);
+        if (literals > static_cast<std::size_t>(in_end - in) ||
+            literals > static_cast<std::size_t>(out_end - out)) {
+            corrupt();
+        }
+        std::memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+        if (in == in_end) {
+            break;  // The last sequence has no match
+        }
+
+        if (in_end - in < 2) {
+            corrupt();
+        }
+        std::size_t offset = in[0] | (static_cast<std::size_t>(in[1]) << 8);
+        in += 2;
+        std::size_t length = read_length(token & 15) + kMinMatch;
+        if (offset == 0 || offset > static_cast<std::size_t>(out - dest) ||
+            length > static_cast<std::size_t>(out_end - out)) {
+            corrupt();
+        }
+        // Byte by byte: the match may overlap the bytes being written
+        const char* match = out - offset;
+        for (std::size_t i = 0; i < length; ++i) {
+            out[i] = match[i];
+        }
+        out += length;
+    }
+    return static_cast<std::size_t>(out - dest);
+}
+
+std::size_t lz4_write_frame(const char* source, std::size_t size, char* dest) {
+    std::size_t length = write_frame_header(dest, size, size);
+    length += write_data_block(source, size, dest + length);
+    put_le32(dest + length, 0);  // End mark
+    return length + 4;
+}
+
+Lz4FrameHeader lz4_parse_frame_header(const char* data, std::size_t size) {
+    Lz4FrameHeader header;
+    if (size < 7 || get_le32(data) != kLz4Magic) {
+        return header;
+    }
+    auto flags = static_cast<unsigned char>(data[4]);
+    if ((flags & 0xc0) != kLz4Version) {
+        return header;
+    }
+    std::size_t length = 4 + 2;
+    if (flags & kLz4ContentSize) {
+        if (size < length + 8) {
+            return header;
+        }
+        for (int i = 0; i < 8; ++i) {
+            header.content_size |=
+                static_cast<std::uint64_t>(static_cast<unsigned char>(data[length + i])) << (8 * i);
+        }
+        length += 8;
+    }
+    if (flags & kLz4DictId) {
+        length += 4;
+    }
+    header.header_size = length + 1;
+    header.block_checksum = (flags & kLz4BlockChecksum) != 0;
+    header.content_checksum = (flags & kLz4ContentChecksum) != 0;
+    header.valid = size >= header.header_size;
+    return header;
+}
+
+std::uint32_t lz4_block_size(const char* data, bool* uncompressed) {
+    std::uint32_t value = get_le32(data);
+    *uncompressed = (value & kLz4Uncompressed) != 0;
+    return value & ~kLz4Uncompressed;
+}
+
+}  // namespace detail
+
+std::string_view compression_extension(Compression codec) {
+    switch (codec) {
+        case Compression::Lz4: return ".lz4";
+        case Compression::Gzip: return ".gz";
+        default: return "";
+    }
+}
+
+bool compression_available(Compression codec) {
+    switch (codec) {
+        case Compression::Lz4: return true;
+#ifdef COLOG_HAS_ZLIB
+        case Compression::Gzip: return true;
+#endif
+        default: return false;
+    }
+}
+
+void require_compression(Compression codec, const std::string& filename) {
+    if (codec != Compression::None && !compression_available(codec)) {
+        throw std::runtime_error("Compression codec for " + filename +
+                                 " not available in this build");
+    }
+}
+
+bool compress_file(const std::string& source, const std::string& destination,
+                   Compression codec, const CompressionProgress& progress, bool append) {
+    if (!compression_available(codec)) {
+        throw std::runtime_error("Compression codec not available in this build");
+    }
+
+    std::ifstream in(source, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Failed to open log file for compression: " + source);
+    }
+    FileWriter out(destination, append);
+
+#ifdef COLOG_HAS_ZLIB
+    if (codec == Compression::Gzip) {
+        return compress_gzip(in, out, progress);
+    }
+#endif
+    return compress_lz4(in, out, progress);
+}
+
+void decompress_gzip_file(const std::string& source, const DecompressedChunk& consume) {
+#ifdef COLOG_HAS_ZLIB
+    std::ifstream in(source, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Failed to open compressed file: " + source);
+    }
+
+    z_stream stream{};
+    // 15 window bits + 16 accepts only the gzip wrapper
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        throw std::runtime_error("Failed to initialise zlib");
+    }
+    std::unique_ptr<z_stream, int (*)(z_stream*)> guard(&stream, inflateEnd);
+
+    std::vector<char> input(kChunkSize);
+    std::vector<char> output(kChunkSize);
+    bool in_member = false;  // Inside a member that has not ended yet
+    while (true) {
+        if (stream.avail_in == 0) {
+            in.read(input.data(), static_cast<std::streamsize>(input.size()));
+            auto got = static_cast<std::size_t>(in.gcount());
+            if (got == 0) {
+                break;
+            }
+            stream.next_in = reinterpret_cast<Bytef*>(input.data());
+            stream.avail_in = static_cast<uInt>(got);
+        }
+        if (!in_member) {
+            inflateReset(&stream);  // Next member of a concatenated file
+            in_member = true;
+        }
+
+        stream.next_out = reinterpret_cast<Bytef*>(output.data());
+        stream.avail_out = static_cast<uInt>(output.size());
+        int result = inflate(&stream, Z_NO_FLUSH);
+        if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+            throw std::runtime_error("Malformed gzip data");
+        }
+        consume(std::string_view(output.data(), output.size() - stream.avail_out));
+        if (result == Z_STREAM_END) {
+            in_member = false;
+        }
+    }
+    if (in.bad()) {
+        throw std::runtime_error("Failed to read compressed file: " + source);
+    }
+    if (in_member) {
+        throw std::runtime_error("Truncated gzip data");
+    }
+#else
+    (void)consume;
+    throw std::runtime_error("gzip support not available in this build: " + source);
+#endif
+}
+
+}  // namespace CoLog
@@ -0,0 +1,99 @@
+#ifndef COLOG_COMPRESSION_H
+#define COLOG_COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace CoLog {
+
+enum class Compression {
+    None,
+    Lz4,   // Built in; standard LZ4 frame format, readable by `lz4 -d`
+    Gzip   // Requires zlib (COLOG_WITH_ZLIB)
+};
+
+// File extension for the codec, including the dot ("" for None)
+std::string_view compression_extension(Compression codec);
+
+// Whether this build can produce the codec
+bool compression_available(Compression codec);
+
+// Throw std::runtime_error naming `filename` if `codec` is set but not
+// available in this build; for constructors of sinks that compress
+void require_compression(Compression codec, const std::string& filename);
+
+// Called after each chunk of input with the number of bytes consumed;
+// returning false aborts the compression.
+using CompressionProgress = std::function<bool(std::size_t bytes)>;
+
+// Compress `source` into `destination`, overwriting it, or with `append`
+// adding a further LZ4 frame / gzip member after its existing content
+// (decoders read concatenated frames and members as one stream). Returns
+// false if `progress` aborted; throws std::runtime_error on I/O errors or
+// if the codec is not available.
+bool compress_file(const std::string& source, const std::string& destination,
+                   Compression codec, const CompressionProgress& progress = {},
+                   bool append = false);
+
+// Receives each chunk of decompressed output
+using DecompressedChunk = std::function<void(std::string_view data)>;
+
+// Decompress the gzip file `source` (concatenated members included) chunk
+// by chunk. Throws std::runtime_error on I/O errors, malformed or truncated
+// input, or if gzip is not available in this build.
+void decompress_gzip_file(const std::string& source, const DecompressedChunk& consume);
+
+namespace detail {
+
+constexpr unsigned char kGzipMagic[2] = {0x1f, 0x8b};
+
+// Worst-case size of an LZ4 block holding `size` input bytes
+constexpr std::size_t lz4_block_bound(std::size_t size) {
+    return size + size / 255 + 16;
+}
+
+// Compress one independent LZ4 block; `dest` must hold lz4_block_bound(size)
+// bytes. Returns the compressed size.
+std::size_t lz4_compress_block(const char* source, std::size_t size, char* dest);
+
+// Decompress one LZ4 block into at most `capacity` bytes. Returns the
+// decompressed size; throws std::runtime_error on malformed input.
+std::size_t lz4_decompress_block(const char* source, std::size_t size, char* dest,
+                                 std::size_t capacity);
+
+constexpr std::uint32_t kLz4FrameMagic = 0x184D2204;
+constexpr std::size_t kLz4MaxBlockSize = 4 * 1024 * 1024;
+constexpr std::size_t kLz4MaxFrameHeader = 4 + 2 + 8 + 4 + 1;
+
+// Worst-case size of a single-block frame for `size` (<= kLz4MaxBlockSize) bytes
+constexpr std::size_t lz4_frame_bound(std::size_t size) {
+    return kLz4MaxFrameHeader + 4 + lz4_block_bound(size) + 4;
+}
+
+// Write `size` (<= kLz4MaxBlockSize) bytes as a complete, self-contained
+// LZ4 frame holding one block and the content size. Returns the frame size.
+std::size_t lz4_write_frame(const char* source, std::size_t size, char* dest);
+
+struct Lz4FrameHeader {
+    bool valid = false;
+    std::size_t header_size = 0;
+    std::uint64_t content_size = 0;  // 0 when not recorded
+    bool block_checksum = false;
+    bool content_checksum = false;
+};
+
+// Parse the frame header at `data`; `valid` is false if it is not an LZ4
+// frame or `size` does not cover the whole header
+Lz4FrameHeader lz4_parse_frame_header(const char* data, std::size_t size);
+
+// Decode a 4-byte block size field (0 marks the end of the frame)
+std::uint32_t lz4_block_size(const char* data, bool* uncompressed);
+
+}  // namespace detail
+
+}  // namespace CoLog
+
+#endif  // COLOG_COMPRESSION_H
@@ -6,6 +6,17 @@ namespace CoLog {
 
 void ConsoleSink::write(std::string_view message) {
     std::lock_guard<std::mutex> lock(mutex_);
+    append(message);
+}
+
+void ConsoleSink::write_batch(std::span<const std::string_view> messages) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::string_view message : messages) {
+        append(message);
+    }
+}
+
+void ConsoleSink::append(std::string_view message) {
     std::cout << message;
 }
 
@@ -2,6 +2,7 @@
 #define COLOG_CONSOLE_SINK_H
 
 #include <mutex>
+#include <span>
 
 #include "sink.h"
 
@@ -13,9 +14,13 @@ public:
     ~ConsoleSink() override = default;
 
     void write(std::string_view message) override;
+    void write_batch(std::span<const std::string_view> messages) override;
     void flush() override;
 
 private:
+    // write() without the lock; the caller holds mutex_
+    void append(std::string_view message);
+
     std::mutex mutex_;
 };
 
@@ -2,9 +2,14 @@
 
 #include <stdexcept>
 
+#include "async/async_backend.h"
+
 namespace CoLog {
 
-FileSink::FileSink(const std::string& filename, bool append) {
+FileSink::FileSink(const std::string& filename, bool append, Compression compress_on_close)
+    : filename_(filename), compress_on_close_(compress_on_close) {
+    require_compression(compress_on_close_, filename);
+
     std::ios::openmode mode = append 
         ? (std::ios::out | std::ios::app) 
         : std::ios::out;
@@ -21,10 +26,22 @@ FileSink::~FileSink() {
         file_.flush();
         file_.close();
     }
+    AsyncBackend::compress_closed_file(filename_, compress_on_close_);
 }
 
 void FileSink::write(std::string_view message) {
     std::lock_guard<std::mutex> lock(mutex_);
+    append(message);
+}
+
+void FileSink::write_batch(std::span<const std::string_view> messages) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::string_view message : messages) {
+        append(message);
+    }
+}
+
+void FileSink::append(std::string_view message) {
     if (file_.is_open()) {
         file_ << message;
     }
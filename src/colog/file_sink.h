@@ -3,24 +3,36 @@
 
 #include <fstream>
 #include <mutex>
+#include <span>
 #include <string>
 
+#include "compression.h"
 #include "sink.h"
 
 namespace CoLog {
 
+// File sink writing through std::ofstream. With `compress_on_close` set,
+// the file is handed to the AsyncBackend's FileCompressor once the sink
+// has closed it (app.log -> app.log.lz4).
 class FileSink : public ISink {
 public:
-    explicit FileSink(const std::string& filename, bool append = true);
+    explicit FileSink(const std::string& filename, bool append = true,
+                      Compression compress_on_close = Compression::None);
     ~FileSink() override;
 
     void write(std::string_view message) override;
+    void write_batch(std::span<const std::string_view> messages) override;
     void flush() override;
 
     bool is_open() const;
 
 private:
+    // write() without the lock; the caller holds mutex_
+    void append(std::string_view message);
+
     std::ofstream file_;
+    std::string filename_;
+    Compression compress_on_close_;
     mutable std::mutex mutex_;
 };
 
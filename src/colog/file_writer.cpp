@@ -0,0 +1,185 @@
+#include "file_writer.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace CoLog {
+
+namespace {
+
+[[noreturn]] void throw_errno(const std::string& what, const std::string& filename) {
+    throw std::runtime_error(what + " " + filename + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+FileWriter::FileWriter(const std::string& filename, bool append) {
+    open(filename, append);
+}
+
+FileWriter::~FileWriter() {
+    close();
+}
+
+FileWriter::FileWriter(FileWriter&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1)), filename_(std::move(other.filename_)) {}
+
+FileWriter& FileWriter::operator=(FileWriter&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd_ = std::exchange(other.fd_, -1);
+        filename_ = std::move(other.filename_);
+    }
+    return *this;
+}
+
+void FileWriter::open(const std::string& filename, bool append) {
+    close();
+#ifdef _WIN32
+    int flags = _O_WRONLY | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC);
+    fd_ = ::_open(filename.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+    fd_ = ::open(filename.c_str(), flags, 0644);
+#endif
+    if (fd_ < 0) {
+        throw_errno("Failed to open log file", filename);
+    }
+    filename_ = filename;
+}
+
+void FileWriter::close() {
+    if (fd_ >= 0) {
+#ifdef _WIN32
+        ::_close(fd_);
+#else
+        ::close(fd_);
+#endif
+        fd_ = -1;
+    }
+}
+
+void FileWriter::write(std::string_view data) {
+    while (!data.empty()) {
+#ifdef _WIN32
+        auto written = ::_write(fd_, data.data(), static_cast<unsigned>(data.size()));
+#else
+        auto written = ::write(fd_, data.data(), data.size());
+#endif
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("Failed to write log file", filename_);
+        }
+        data.remove_prefix(static_cast<std::size_t>(written));
+    }
+}
+
+void FileWriter::write(std::string_view first, std::string_view second) {
+#ifdef _WIN32
+    write(first);
+    write(second);
+#else
+    while (!first.empty()) {
+        iovec iov[2] = {{const_cast<char*>(first.data()), first.size()},
+                        {const_cast<char*>(second.data()), second.size()}};
+        auto written = ::writev(fd_, iov, 2);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("Failed to write log file", filename_);
+        }
+        auto n = static_cast<std::size_t>(written);
+        if (n < first.size()) {
+            first.remove_prefix(n);
+            continue;
+        }
+        second.remove_prefix(n - first.size());
+        first = {};
+    }
+    write(second);
+#endif
+}
+
+void FileWriter::write(std::string_view first, std::span<const std::string_view> rest) {
+#ifdef _WIN32
+    write(first);
+    for (std::string_view piece : rest) {
+        write(piece);
+    }
+#else
+    iovec iov[kMaxPieces];
+    for (;;) {
+        // Gather what is left of `first`, then as many pieces as fit
+        int count = 0;
+        if (!first.empty()) {
+            iov[count++] = {const_cast<char*>(first.data()), first.size()};
+        }
+        std::size_t taken = 0;
+        for (; taken < rest.size() && static_cast<std::size_t>(count) < kMaxPieces; ++taken) {
+            if (!rest[taken].empty()) {
+                iov[count++] = {const_cast<char*>(rest[taken].data()), rest[taken].size()};
+            }
+        }
+        if (count == 0) {
+            return;
+        }
+
+        auto written = ::writev(fd_, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("Failed to write log file", filename_);
+        }
+
+        // Step past what went out; a partly written piece becomes `first`
+        auto n = static_cast<std::size_t>(written);
+        if (n < first.size()) {
+            first.remove_prefix(n);
+            continue;
+        }
+        n -= first.size();
+        first = {};
+        std::size_t done = 0;
+        while (done < taken && n >= rest[done].size()) {
+            n -= rest[done].size();
+            ++done;
+        }
+        rest = rest.subspan(done);
+        if (n > 0) {
+            first = rest.front().substr(n);
+            rest = rest.subspan(1);
+        }
+    }
+#endif
+}
+
+void FileWriter::sync() {
+    if (fd_ < 0) {
+        return;
+    }
+#ifdef _WIN32
+    ::_commit(fd_);
+#elif defined(__APPLE__)
+    ::fsync(fd_);
+#else
+    ::fdatasync(fd_);
+#endif
+}
+
+}  // namespace CoLog
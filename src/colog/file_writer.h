@@ -0,0 +1,55 @@
+#ifndef COLOG_FILE_WRITER_H
+#define COLOG_FILE_WRITER_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace CoLog {
+
+// Thin wrapper over a raw file descriptor. Writes go straight to the
+// write()/writev() syscalls and are retried until complete, so callers do
+// their own buffering. Throws std::runtime_error if the file cannot be
+// opened or a write fails.
+class FileWriter {
+public:
+    FileWriter() = default;
+    FileWriter(const std::string& filename, bool append);
+    ~FileWriter();
+
+    // Non-copyable, movable
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+    FileWriter(FileWriter&& other) noexcept;
+    FileWriter& operator=(FileWriter&& other) noexcept;
+
+    void open(const std::string& filename, bool append);
+    void close();
+    bool is_open() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+
+    void write(std::string_view data);
+
+    // Write both pieces with a single writev() where possible
+    void write(std::string_view first, std::string_view second);
+
+    // Write `first` and then every piece of `rest` with as few writev()
+    // calls as possible (one per kMaxPieces pieces)
+    void write(std::string_view first, std::span<const std::string_view> rest);
+
+    static constexpr std::size_t kMaxPieces = 512;
+
+    // Flush kernel buffers to the device (fdatasync)
+    void sync();
+
+    const std::string& filename() const { return filename_; }
+
+private:
+    int fd_ = -1;
+    std::string filename_;
+};
+
+}  // namespace CoLog
+
+#endif  // COLOG_FILE_WRITER_H
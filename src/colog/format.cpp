@@ -0,0 +1,347 @@
+#include "format.h"
+
+#include <charconv>
+#include <limits>
+
+namespace CoLog {
+
+namespace detail {
+
+void format_string_is_malformed() {}
+void format_argument_count_mismatch() {}
+
+}  // namespace detail
+
+namespace {
+
+struct FormatSpec {
+    char fill = ' ';
+    char align = '\0';  // '<', '>', '^' or '\0' for the type's default
+    char sign = '-';    // '-', '+' or ' '
+    bool alternate = false;
+    bool zero_pad = false;
+    int width = 0;
+    int precision = -1;
+    char type = '\0';
+};
+
+bool is_align(char c) { return c == '<' || c == '>' || c == '^'; }
+
+int parse_int(std::string_view spec, std::size_t& pos) {
+    int value = 0;
+    while (pos < spec.size() && spec[pos] >= '0' && spec[pos] <= '9') {
+        value = value * 10 + (spec[pos] - '0');
+        ++pos;
+    }
+    return value;
+}
+
+FormatSpec parse_spec(std::string_view spec) {
+    FormatSpec result;
+    std::size_t pos = 0;
+
+    if (spec.size() >= 2 && is_align(spec[1])) {
+        result.fill = spec[0];
+        result.align = spec[1];
+        pos = 2;
+    } else if (!spec.empty() && is_align(spec[0])) {
+        result.align = spec[0];
+        pos = 1;
+    }
+
+    if (pos < spec.size() && (spec[pos] == '+' || spec[pos] == '-' || spec[pos] == ' ')) {
+        result.sign = spec[pos++];
+    }
+    if (pos < spec.size() && spec[pos] == '#') {
+        result.alternate = true;
+        ++pos;
+    }
+    if (pos < spec.size() && spec[pos] == '0') {
+        result.zero_pad = true;
+        ++pos;
+    }
+    result.width = parse_int(spec, pos);
+    if (pos < spec.size() && spec[pos] == '.') {
+        ++pos;
+        result.precision = parse_int(spec, pos);
+    }
+    if (pos < spec.size()) {
+        result.type = spec[pos];
+    }
+    return result;
+}
+
+// Append `body` padded to spec.width. `prefix` (sign, 0x) stays in front
+// of zero padding; `default_align` applies when the spec has none.
+void write_padded(std::string& out, const FormatSpec& spec, std::string_view prefix,
+                  std::string_view body, char default_align) {
+    std::size_t length = prefix.size() + body.size();
+    std::size_t width = spec.width > 0 ? static_cast<std::size_t>(spec.width) : 0;
+    if (length >= width) {
+        out.append(prefix);
+        out.append(body);
+        return;
+    }
+
+    std::size_t padding = width - length;
+    if (spec.zero_pad && spec.align == '\0') {
+        out.append(prefix);
+        out.append(padding, '0');
+        out.append(body);
+        return;
+    }
+
+    char align = spec.align ? spec.align : default_align;
+    std::size_t left = align == '>' ? padding : align == '^' ? padding / 2 : 0;
+    out.append(left, spec.fill);
+    out.append(prefix);
+    out.append(body);
+    out.append(padding - left, spec.fill);
+}
+
+void write_unsigned(std::string& out, const FormatSpec& spec, std::uint64_t value,
+                    bool negative) {
+    int base = 10;
+    std::string_view alt_prefix;
+    switch (spec.type) {
+        case 'x': base = 16; alt_prefix = "0x"; break;
+        case 'X': base = 16; alt_prefix = "0X"; break;
+        case 'o': base = 8; alt_prefix = "0"; break;
+        case 'b': base = 2; alt_prefix = "0b"; break;
+        case 'B': base = 2; alt_prefix = "0B"; break;
+        default: break;
+    }
+
+    char digits[70];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value, base);
+    if (spec.type == 'X') {
+        for (char* p = digits; p != end; ++p) {
+            if (*p >= 'a' && *p <= 'f') *p = static_cast<char>(*p - 'a' + 'A');
+        }
+    }
+
+    char prefix[4];
+    std::size_t prefix_len = 0;
+    if (negative) {
+        prefix[prefix_len++] = '-';
+    } else if (spec.sign == '+' || spec.sign == ' ') {
+        prefix[prefix_len++] = spec.sign;
+    }
+    if (spec.alternate) {
+        for (char c : alt_prefix) prefix[prefix_len++] = c;
+    }
+
+    write_padded(out, spec, std::string_view(prefix, prefix_len),
+                 std::string_view(digits, static_cast<std::size_t>(end - digits)), '>');
+}
+
+void write_signed(std::string& out, const FormatSpec& spec, std::int64_t value) {
+    if (spec.type == 'c') {
+        char c = static_cast<char>(value);
+        write_padded(out, spec, {}, std::string_view(&c, 1), '<');
+        return;
+    }
+    bool negative = value < 0;
+    // Negate in unsigned space so INT64_MIN does not overflow
+    std::uint64_t magnitude = negative ? 0 - static_cast<std::uint64_t>(value)
+                                       : static_cast<std::uint64_t>(value);
+    write_unsigned(out, spec, magnitude, negative);
+}
+
+void write_double(std::string& out, const FormatSpec& spec, double value) {
+    char digits[128];
+    std::to_chars_result result{};
+    char* last = digits + sizeof(digits);
+    int precision = spec.precision;
+
+    switch (spec.type) {
+        case 'f': case 'F':
+            result = std::to_chars(digits, last, value, std::chars_format::fixed,
+                                   precision < 0 ? 6 : precision);
+            break;
+        case 'e': case 'E':
+            result = std::to_chars(digits, last, value, std::chars_format::scientific,
+                                   precision < 0 ? 6 : precision);
+            break;
+        case 'g': case 'G':
+            result = std::to_chars(digits, last, value, std::chars_format::general,
+                                   precision < 0 ? 6 : precision);
+            break;
+        default:
+            result = precision < 0
+                         ? std::to_chars(digits, last, value)
+                         : std::to_chars(digits, last, value, std::chars_format::general,
+                                         precision);
+            break;
+    }
+    if (result.ec != std::errc{}) {
+        write_padded(out, spec, {}, "?", '>');
+        return;
+    }
+
+    if (spec.type == 'F' || spec.type == 'E' || spec.type == 'G') {
+        for (char* p = digits; p != result.ptr; ++p) {
+            if (*p >= 'a' && *p <= 'z') *p = static_cast<char>(*p - 'a' + 'A');
+        }
+    }
+
+    std::string_view body(digits, static_cast<std::size_t>(result.ptr - digits));
+    std::string_view prefix;
+    if (!body.empty() && body.front() == '-') {
+        prefix = "-";
+        body.remove_prefix(1);
+    } else if (spec.sign == '+') {
+        prefix = "+";
+    } else if (spec.sign == ' ') {
+        prefix = " ";
+    }
+    write_padded(out, spec, prefix, body, '>');
+}
+
+void write_string(std::string& out, const FormatSpec& spec, std::string_view value) {
+    if (spec.precision >= 0 && static_cast<std::size_t>(spec.precision) < value.size()) {
+        value = value.substr(0, static_cast<std::size_t>(spec.precision));
+    }
+    write_padded(out, spec, {}, value, '<');
+}
+
+/**
+ * @brief Sequential reader over an encoded argument stream.
+ */
+class ArgReader {
+public:
+    explicit ArgReader(std::span<const std::byte> args) : args_(args) {}
+
+    // Format the next argument; returns false when the stream is exhausted.
+    bool format_next(std::string& out, const FormatSpec& spec) {
+        if (pos_ >= args_.size()) {
+            return false;
+        }
+        auto type = static_cast<ArgType>(args_[pos_++]);
+        switch (type) {
+            case ArgType::Bool: {
+                if (!has(1)) return false;
+                bool value = args_[pos_++] != std::byte{0};
+                if (spec.type != '\0' && spec.type != 's') {
+                    write_signed(out, spec, value ? 1 : 0);
+                } else {
+                    write_string(out, spec, value ? "true" : "false");
+                }
+                return true;
+            }
+            case ArgType::Char: {
+                if (!has(1)) return false;
+                char value = static_cast<char>(args_[pos_++]);
+                if (spec.type != '\0' && spec.type != 'c') {
+                    write_signed(out, spec, value);
+                } else {
+                    write_padded(out, spec, {}, std::string_view(&value, 1), '<');
+                }
+                return true;
+            }
+            case ArgType::Int: {
+                std::int64_t value;
+                if (!read(value)) return false;
+                write_signed(out, spec, value);
+                return true;
+            }
+            case ArgType::UInt: {
+                std::uint64_t value;
+                if (!read(value)) return false;
+                if (spec.type == 'c') {
+                    write_signed(out, spec, static_cast<std::int64_t>(value));
+                } else {
+                    write_unsigned(out, spec, value, false);
+                }
+                return true;
+            }
+            case ArgType::Double: {
+                double value;
+                if (!read(value)) return false;
+                write_double(out, spec, value);
+                return true;
+            }
+            case ArgType::String: {
+                std::uint32_t length;
+                if (!read(length) || !has(length)) return false;
+                std::string_view value(reinterpret_cast<const char*>(args_.data() + pos_), length);
+                pos_ += length;
+                write_string(out, spec, value);
+                return true;
+            }
+            case ArgType::Pointer: {
+                std::uint64_t value;
+                if (!read(value)) return false;
+                FormatSpec pointer_spec = spec;
+                pointer_spec.type = 'x';
+                pointer_spec.alternate = true;
+                write_unsigned(out, pointer_spec, value, false);
+                return true;
+            }
+            case ArgType::None:
+                break;
+        }
+        // Unknown tag: the rest of the stream cannot be trusted
+        pos_ = args_.size();
+        return false;
+    }
+
+private:
+    bool has(std::size_t n) const { return args_.size() - pos_ >= n; }
+
+    template <typename T>
+    bool read(T& value) {
+        if (!has(sizeof(T))) return false;
+        std::memcpy(&value, args_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    std::span<const std::byte> args_;
+    std::size_t pos_ = 0;
+};
+
+}  // namespace
+
+void vformat_to(std::string& out, std::string_view fmt, std::span<const std::byte> args) {
+    ArgReader reader(args);
+    std::size_t literal_start = 0;
+
+    for (std::size_t i = 0; i < fmt.size(); ++i) {
+        char c = fmt[i];
+        if (c != '{' && c != '}') {
+            continue;
+        }
+
+        out.append(fmt.data() + literal_start, i - literal_start);
+
+        // Escaped "{{" or "}}"
+        if (i + 1 < fmt.size() && fmt[i + 1] == c) {
+            out.push_back(c);
+            literal_start = ++i + 1;
+            continue;
+        }
+
+        std::size_t close = c == '{' ? fmt.find('}', i + 1) : std::string_view::npos;
+        if (close == std::string_view::npos) {
+            // Stray brace: emit it verbatim
+            out.push_back(c);
+            literal_start = i + 1;
+            continue;
+        }
+
+        std::string_view spec = fmt.substr(i + 1, close - i - 1);
+        if (!spec.empty() && spec.front() == ':') {
+            spec.remove_prefix(1);
+        }
+        if (!reader.format_next(out, parse_spec(spec))) {
+            out.append("{?}");
+        }
+        i = close;
+        literal_start = close + 1;
+    }
+
+    out.append(fmt.data() + literal_start, fmt.size() - literal_start);
+}
+
+}  // namespace CoLog
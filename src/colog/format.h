@@ -0,0 +1,275 @@
+#ifndef COLOG_FORMAT_H
+#define COLOG_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <source_location>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "log_site.h"
+
+namespace CoLog {
+
+/**
+ * @brief Type tag written in front of every encoded format argument.
+ *
+ * Arguments are captured on the calling thread as a compact byte stream
+ * (tag followed by the raw value) so the actual text formatting can run
+ * later, typically on the async backend thread.
+ */
+enum class ArgType : std::uint8_t {
+    None = 0,
+    Bool,
+    Char,
+    Int,      // int64_t payload
+    UInt,     // uint64_t payload
+    Double,   // double payload
+    String,   // uint32_t length followed by the bytes
+    Pointer   // uint64_t payload
+};
+
+namespace detail {
+
+constexpr std::size_t kFormatStringError = static_cast<std::size_t>(-1);
+
+/**
+ * @brief Count `{}` placeholders in a format string.
+ * @return Number of placeholders, or kFormatStringError if the string is
+ *         malformed (unbalanced braces or explicit argument indices).
+ */
+constexpr std::size_t count_placeholders(std::string_view fmt) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < fmt.size(); ++i) {
+        if (fmt[i] == '{') {
+            if (i + 1 < fmt.size() && fmt[i + 1] == '{') {
+                ++i;
+                continue;
+            }
+            std::size_t close = fmt.find('}', i + 1);
+            if (close == std::string_view::npos) {
+                return kFormatStringError;
+            }
+            // Only automatic indexing is supported: "{}" or "{:spec}"
+            if (close > i + 1 && fmt[i + 1] != ':') {
+                return kFormatStringError;
+            }
+            ++count;
+            i = close;
+        } else if (fmt[i] == '}') {
+            if (i + 1 < fmt.size() && fmt[i + 1] == '}') {
+                ++i;
+                continue;
+            }
+            return kFormatStringError;
+        }
+    }
+    return count;
+}
+
+// Intentionally not constexpr: calling these from the consteval
+// FormatString constructor turns a bad format string into a compile error.
+void format_string_is_malformed();
+void format_argument_count_mismatch();
+
+template <typename T>
+consteval ArgType arg_type_of() {
+    using U = std::remove_cvref_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+        return ArgType::Bool;
+    } else if constexpr (std::is_same_v<U, char>) {
+        return ArgType::Char;
+    } else if constexpr (std::is_enum_v<U>) {
+        return arg_type_of<std::underlying_type_t<U>>();
+    } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+        return ArgType::Int;
+    } else if constexpr (std::is_integral_v<U>) {
+        return ArgType::UInt;
+    } else if constexpr (std::is_floating_point_v<U>) {
+        return ArgType::Double;
+    } else if constexpr (std::is_null_pointer_v<U>) {
+        // nullptr_t converts to std::string_view in C++20, which would
+        // construct a view from a null pointer on the backend
+        return ArgType::Pointer;
+    } else if constexpr (std::is_convertible_v<const U&, std::string_view>) {
+        return ArgType::String;
+    } else if constexpr (std::is_pointer_v<U>) {
+        return ArgType::Pointer;
+    } else {
+        return ArgType::None;
+    }
+}
+
+template <typename T>
+std::string_view as_string_view(const T& value) {
+    if constexpr (std::is_pointer_v<std::remove_cvref_t<T>>) {
+        return value ? std::string_view(value) : std::string_view("(null)");
+    } else {
+        return std::string_view(value);
+    }
+}
+
+}  // namespace detail
+
+/**
+ * @brief Types that can be captured as deferred format arguments.
+ *
+ * Arithmetic types, enums, pointers and anything convertible to
+ * std::string_view (the characters are copied, not referenced).
+ */
+template <typename T>
+concept FormatArgument = detail::arg_type_of<T>() != ArgType::None;
+
+/**
+ * @brief A compile-time checked format string plus its call site.
+ *
+ * Only string literals (or other constant expressions) are accepted, which
+ * guarantees the pointer has static storage duration and can be carried
+ * through the async queue without copying the characters. The number of
+ * `{}` placeholders is validated against the argument count at compile time.
+ *
+ * The COLOG_LOG macros also pass the call site's static LogSite, whose id
+ * is then used directly; otherwise the site is interned on first use.
+ */
+template <typename... Args>
+class BasicFormatString {
+public:
+    consteval BasicFormatString(const char* str,
+                                std::source_location loc = std::source_location::current())
+        : str_(str), loc_(loc) {
+        check();
+    }
+
+    consteval BasicFormatString(const LogSite& site, const char* str,
+                                std::source_location loc = std::source_location::current())
+        : str_(str), loc_(loc), site_(&site) {
+        check();
+    }
+
+    constexpr const char* get() const { return str_; }
+    constexpr std::source_location location() const { return loc_; }
+
+    /**
+     * @brief Registry id of the call site (see log_site.h).
+     */
+    std::uint32_t site_id() const {
+        return site_ != nullptr ? site_->id() : SiteRegistry::instance().intern(str_, loc_);
+    }
+
+private:
+    consteval void check() const {
+        std::size_t count = detail::count_placeholders(str_);
+        if (count == detail::kFormatStringError) {
+            detail::format_string_is_malformed();
+        }
+        if (count != sizeof...(Args)) {
+            detail::format_argument_count_mismatch();
+        }
+    }
+
+    const char* str_;
+    std::source_location loc_;
+    const LogSite* site_ = nullptr;
+};
+
+template <typename... Args>
+using FormatString = BasicFormatString<std::type_identity_t<Args>...>;
+
+/**
+ * @brief Number of bytes encode_args() will write for the given arguments.
+ */
+template <FormatArgument... Args>
+std::size_t encoded_args_size(const Args&... args) {
+    auto one = [](const auto& arg) -> std::size_t {
+        using T = std::remove_cvref_t<decltype(arg)>;
+        constexpr ArgType type = detail::arg_type_of<T>();
+        if constexpr (type == ArgType::String) {
+            return 1 + sizeof(std::uint32_t) + detail::as_string_view(arg).size();
+        } else if constexpr (type == ArgType::Bool || type == ArgType::Char) {
+            return 2;
+        } else {
+            return 1 + sizeof(std::uint64_t);
+        }
+    };
+    return (std::size_t{0} + ... + one(args));
+}
+
+/**
+ * @brief Serialize arguments into @p dst (which must hold encoded_args_size()).
+ * @return Pointer one past the last written byte.
+ */
+template <FormatArgument... Args>
+std::byte* encode_args(std::byte* dst, const Args&... args) {
+    auto one = [&dst](const auto& arg) {
+        using T = std::remove_cvref_t<decltype(arg)>;
+        constexpr ArgType type = detail::arg_type_of<T>();
+        *dst++ = static_cast<std::byte>(type);
+        if constexpr (type == ArgType::String) {
+            std::string_view sv = detail::as_string_view(arg);
+            auto len = static_cast<std::uint32_t>(sv.size());
+            std::memcpy(dst, &len, sizeof(len));
+            dst += sizeof(len);
+            std::memcpy(dst, sv.data(), len);
+            dst += len;
+        } else if constexpr (type == ArgType::Bool || type == ArgType::Char) {
+            *dst++ = static_cast<std::byte>(arg);
+        } else {
+            std::uint64_t raw = 0;
+            if constexpr (type == ArgType::Int) {
+                auto v = static_cast<std::int64_t>(arg);
+                std::memcpy(&raw, &v, sizeof(v));
+            } else if constexpr (type == ArgType::UInt) {
+                raw = static_cast<std::uint64_t>(arg);
+            } else if constexpr (type == ArgType::Double) {
+                auto v = static_cast<double>(arg);
+                std::memcpy(&raw, &v, sizeof(v));
+            } else {
+                raw = reinterpret_cast<std::uintptr_t>(static_cast<const void*>(arg));
+            }
+            std::memcpy(dst, &raw, sizeof(raw));
+            dst += sizeof(raw);
+        }
+    };
+    (one(args), ...);
+    return dst;
+}
+
+/**
+ * @brief Format @p fmt with previously encoded arguments, appending to @p out.
+ *
+ * Supports `{}` and `{:[[fill]align][sign][#][0][width][.precision][type]}`
+ * placeholders. Missing arguments are rendered as `{?}`.
+ */
+void vformat_to(std::string& out, std::string_view fmt, std::span<const std::byte> args);
+
+/**
+ * @brief Format immediately on the calling thread.
+ */
+template <FormatArgument... Args>
+std::string format(std::string_view fmt, const Args&... args) {
+    std::string out;
+    if constexpr (sizeof...(Args) == 0) {
+        vformat_to(out, fmt, {});
+    } else {
+        constexpr std::size_t kStackBytes = 256;
+        std::size_t size = encoded_args_size(args...);
+        if (size <= kStackBytes) {
+            std::byte buffer[kStackBytes];
+            encode_args(buffer, args...);
+            vformat_to(out, fmt, std::span<const std::byte>(buffer, size));
+        } else {
+            std::string heap(size, '\0');
+            auto* buffer = reinterpret_cast<std::byte*>(heap.data());
+            encode_args(buffer, args...);
+            vformat_to(out, fmt, std::span<const std::byte>(buffer, size));
+        }
+    }
+    return out;
+}
+
+}  // namespace CoLog
+
+#endif  // COLOG_FORMAT_H
@@ -12,6 +12,16 @@ class IFormatter {
 public:
     virtual ~IFormatter() = default;
     virtual std::string format(const LogRecord& record) = 0;
+
+    // Append the formatted record to `dest`. The async backend calls this
+    // with a reused buffer; override it to avoid a temporary string.
+    virtual void format_to(const LogRecord& record, std::string& dest) {
+        dest += format(record);
+    }
+
+    // Formatters that work from LogRecord::format and format_args alone
+    // return false so the async backend skips rendering the message text.
+    virtual bool needs_message() const { return true; }
 };
 
 using FormatterPtr = std::shared_ptr<IFormatter>;
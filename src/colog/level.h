@@ -3,6 +3,23 @@
 
 #include <string_view>
 
+// Numeric levels for preprocessor use; they match LogLevel
+#define COLOG_LEVEL_TRACE 0
+#define COLOG_LEVEL_DEBUG 1
+#define COLOG_LEVEL_INFO 2
+#define COLOG_LEVEL_WARN 3
+#define COLOG_LEVEL_ERROR 4
+#define COLOG_LEVEL_CRITICAL 5
+#define COLOG_LEVEL_OFF 6
+
+// Build-time threshold: calls below it are compiled out (the COLOG_DEBUG
+// etc. macros expand to nothing, and should_log() folds to false). Set
+// with -DCOLOG_ACTIVE_LEVEL=COLOG_LEVEL_INFO or the CMake cache variable
+// of the same name.
+#ifndef COLOG_ACTIVE_LEVEL
+#define COLOG_ACTIVE_LEVEL COLOG_LEVEL_TRACE
+#endif
+
 namespace CoLog {
 
 enum class LogLevel {
@@ -15,6 +32,13 @@ enum class LogLevel {
     Off = 6  // Used to disable logging
 };
 
+constexpr LogLevel kActiveLevel = static_cast<LogLevel>(COLOG_ACTIVE_LEVEL);
+
+// True if calls at `level` survive the build-time threshold
+constexpr bool is_active(LogLevel level) {
+    return level >= kActiveLevel;
+}
+
 constexpr std::string_view to_string(LogLevel level) {
     switch (level) {
         case LogLevel::Trace:    return "TRACE";
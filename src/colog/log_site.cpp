@@ -0,0 +1,108 @@
+#include "log_site.h"
+
+#include <stdexcept>
+
+namespace CoLog {
+
+namespace {
+
+/**
+ * @brief Per-thread direct-mapped cache of interned site ids.
+ *
+ * Keyed by the same fields as the shared table; a collision simply
+ * overwrites the slot.
+ */
+struct InternCacheEntry {
+    const char* format = nullptr;
+    const char* file = nullptr;
+    std::uint32_t line = 0;
+    std::uint32_t column = 0;
+    std::uint32_t id = 0;
+};
+
+constexpr std::size_t kInternCacheSize = 256;
+
+thread_local InternCacheEntry t_intern_cache[kInternCacheSize];
+
+}  // namespace
+
+std::uint32_t LogSite::register_site() const {
+    SiteRegistry& registry = SiteRegistry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex_);
+    // Another thread may have registered the site while we waited
+    std::uint32_t id = id_.load(std::memory_order_relaxed);
+    return id != 0 ? id : registry.add(*this);
+}
+
+SiteRegistry& SiteRegistry::instance() {
+    // Never destroyed: static sites, and the async backend's own teardown,
+    // may still look up ids during static destruction
+    static SiteRegistry* instance = new SiteRegistry();
+    return *instance;
+}
+
+std::size_t SiteRegistry::InternKeyHash::operator()(const InternKey& key) const {
+    std::size_t hash = std::hash<const void*>{}(key.format);
+    hash ^= std::hash<const void*>{}(key.file) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    hash ^= (static_cast<std::size_t>(key.line) << 16) ^ key.column;
+    return hash;
+}
+
+std::uint32_t SiteRegistry::intern(const char* format, std::source_location location) {
+    InternKey key{format, location.file_name(), location.line(), location.column()};
+
+    auto bits = reinterpret_cast<std::uintptr_t>(format) ^
+                reinterpret_cast<std::uintptr_t>(key.file);
+    std::size_t slot = ((bits >> 4) ^ (key.line * 31u) ^ key.column) % kInternCacheSize;
+    InternCacheEntry& entry = t_intern_cache[slot];
+    if (entry.id != 0 && entry.format == key.format && entry.file == key.file &&
+        entry.line == key.line && entry.column == key.column) {
+        return entry.id;
+    }
+
+    std::uint32_t id = intern_slow(key, location);
+    entry = {key.format, key.file, key.line, key.column, id};
+    return id;
+}
+
+std::uint32_t SiteRegistry::intern_slow(const InternKey& key, std::source_location location) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = interned_.find(key);
+    if (it != interned_.end()) {
+        return it->second;
+    }
+    interned_sites_.emplace_back(new LogSite(LogSite::Interned{}, key.format, location));
+    std::uint32_t id = add(*interned_sites_.back());
+    interned_.emplace(key, id);
+    return id;
+}
+
+std::uint32_t SiteRegistry::add(const LogSite& site) {
+    std::uint32_t id = next_id_.load(std::memory_order_relaxed);
+    if (id >= kChunkSize * kMaxChunks) {
+        throw std::length_error("CoLog: too many log call sites");
+    }
+
+    std::atomic<Chunk*>& chunk = chunks_[id / kChunkSize];
+    if (chunk.load(std::memory_order_relaxed) == nullptr) {
+        chunk.store(new Chunk(), std::memory_order_release);
+    }
+    (*chunk.load(std::memory_order_relaxed))[id % kChunkSize].store(&site,
+                                                                    std::memory_order_release);
+    // Publish the id last, so find() succeeds for anyone who has seen it
+    site.id_.store(id, std::memory_order_release);
+    next_id_.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+void SiteRegistry::for_each(
+    const std::function<void(std::uint32_t, const LogSite&)>& visit) const {
+    std::uint32_t count = next_id_.load(std::memory_order_acquire);
+    for (std::uint32_t id = 1; id < count; ++id) {
+        if (const LogSite* site = find(id)) {
+            visit(id, *site);
+        }
+    }
+}
+
+}  // namespace CoLog
@@ -0,0 +1,214 @@
+#ifndef COLOG_LOG_SITE_H
+#define COLOG_LOG_SITE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <unordered_map>
+#include <vector>
+
+#include "level.h"
+
+namespace CoLog {
+
+/**
+ * @brief A log call site: its format string and source location.
+ *
+ * Registered with the SiteRegistry the first time it logs and referred to
+ * by a small integer id from then on, so async queue records carry four
+ * bytes instead of the format and location pointers. The COLOG_LOG macros
+ * below place one of these in a function-local static at each call site;
+ * plain `logger->info(...)` calls are interned by the registry instead.
+ */
+class LogSite {
+public:
+    consteval explicit LogSite(const char* format,
+                               std::source_location location = std::source_location::current())
+        : format_(format), location_(location) {}
+
+    // Non-copyable: the registry refers to sites by address
+    LogSite(const LogSite&) = delete;
+    LogSite& operator=(const LogSite&) = delete;
+
+    // Null for sites that log preformatted messages
+    const char* format() const { return format_; }
+    const std::source_location& location() const { return location_; }
+
+    /**
+     * @brief The site's registry id (never 0), registering it on first use.
+     */
+    std::uint32_t id() const {
+        std::uint32_t id = id_.load(std::memory_order_acquire);
+        return id != 0 ? id : register_site();
+    }
+
+    /**
+     * @brief Records from this site processed by the async backend.
+     */
+    std::uint64_t records() const { return records_.load(std::memory_order_relaxed); }
+
+private:
+    friend class SiteRegistry;
+
+    struct Interned {};
+
+    // Runtime construction, for sites interned by the registry
+    LogSite(Interned, const char* format, std::source_location location)
+        : format_(format), location_(location) {}
+
+    std::uint32_t register_site() const;
+
+    const char* format_;
+    std::source_location location_;
+    mutable std::atomic<std::uint32_t> id_{0};
+    mutable std::atomic<std::uint64_t> records_{0};
+};
+
+/**
+ * @brief Process-wide table mapping site ids to LogSite objects.
+ *
+ * Registration takes a mutex and happens once per site; find() is a
+ * lock-free lookup in a table of fixed-size chunks that never move.
+ */
+class SiteRegistry {
+public:
+    static SiteRegistry& instance();
+
+    /**
+     * @brief Id for a site without a static LogSite object.
+     *
+     * Keyed by format pointer and source location; repeated calls hit a
+     * small per-thread cache before falling back to the shared table.
+     */
+    std::uint32_t intern(const char* format, std::source_location location);
+
+    /**
+     * @brief The site registered under @p id, or nullptr.
+     */
+    const LogSite* find(std::uint32_t id) const {
+        if (id == 0 || id >= kChunkSize * kMaxChunks) {
+            return nullptr;
+        }
+        const Chunk* chunk = chunks_[id / kChunkSize].load(std::memory_order_acquire);
+        return chunk != nullptr ? (*chunk)[id % kChunkSize].load(std::memory_order_acquire)
+                                : nullptr;
+    }
+
+    /**
+     * @brief Count a processed record against its site (backend use).
+     */
+    static void count_record(const LogSite& site) {
+        site.records_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Number of ids handed out so far.
+     */
+    std::uint32_t size() const { return next_id_.load(std::memory_order_acquire) - 1; }
+
+    /**
+     * @brief Visit every registered site, e.g. to report per-site record counts.
+     */
+    void for_each(const std::function<void(std::uint32_t, const LogSite&)>& visit) const;
+
+private:
+    friend class LogSite;
+
+    static constexpr std::uint32_t kChunkSize = 4096;
+    static constexpr std::uint32_t kMaxChunks = 4096;
+
+    using Chunk = std::array<std::atomic<const LogSite*>, kChunkSize>;
+
+    struct InternKey {
+        const char* format;
+        const char* file;
+        std::uint32_t line;
+        std::uint32_t column;
+
+        bool operator==(const InternKey&) const = default;
+    };
+
+    struct InternKeyHash {
+        std::size_t operator()(const InternKey& key) const;
+    };
+
+    SiteRegistry() = default;
+
+    // Assign the next id to @p site; caller holds mutex_
+    std::uint32_t add(const LogSite& site);
+    std::uint32_t intern_slow(const InternKey& key, std::source_location location);
+
+    std::array<std::atomic<Chunk*>, kMaxChunks> chunks_{};
+    std::atomic<std::uint32_t> next_id_{1};
+
+    mutable std::mutex mutex_;
+    std::unordered_map<InternKey, std::uint32_t, InternKeyHash> interned_;
+    std::vector<std::unique_ptr<LogSite>> interned_sites_;
+};
+
+}  // namespace CoLog
+
+/**
+ * @brief Log through a static per-call-site LogSite.
+ *
+ * Works with Logger and AsyncLogger (pointers or smart pointers); the
+ * format string is checked at compile time as for `logger->info(...)`.
+ * The arguments are only evaluated once the level passes both the
+ * build-time threshold and the logger's runtime level:
+ *
+ *     COLOG_DEBUG(logger, "state {}", dump_state());  // dump_state() only if enabled
+ *
+ * The per-level macros below COLOG_ACTIVE_LEVEL expand to nothing.
+ */
+#define COLOG_LOG(logger, level, fmt, ...)                                          \
+    do {                                                                            \
+        auto&& colog_logger_ = (logger);                                            \
+        if (colog_logger_->should_log(level)) {                                     \
+            static constinit ::CoLog::LogSite colog_site_{fmt};                     \
+            colog_logger_->log((level), {colog_site_, fmt} __VA_OPT__(, ) __VA_ARGS__); \
+        }                                                                           \
+    } while (false)
+
+#define COLOG_DISABLED_LOG(...) ((void)0)
+
+#if COLOG_ACTIVE_LEVEL <= COLOG_LEVEL_TRACE
+#define COLOG_TRACE(logger, ...) COLOG_LOG(logger, ::CoLog::LogLevel::Trace, __VA_ARGS__)
+#else
+#define COLOG_TRACE(logger, ...) COLOG_DISABLED_LOG()
+#endif
+
+#if COLOG_ACTIVE_LEVEL <= COLOG_LEVEL_DEBUG
+#define COLOG_DEBUG(logger, ...) COLOG_LOG(logger, ::CoLog::LogLevel::Debug, __VA_ARGS__)
+#else
+#define COLOG_DEBUG(logger, ...) COLOG_DISABLED_LOG()
+#endif
+
+#if COLOG_ACTIVE_LEVEL <= COLOG_LEVEL_INFO
+#define COLOG_INFO(logger, ...) COLOG_LOG(logger, ::CoLog::LogLevel::Info, __VA_ARGS__)
+#else
+#define COLOG_INFO(logger, ...) COLOG_DISABLED_LOG()
+#endif
+
+#if COLOG_ACTIVE_LEVEL <= COLOG_LEVEL_WARN
+#define COLOG_WARN(logger, ...) COLOG_LOG(logger, ::CoLog::LogLevel::Warn, __VA_ARGS__)
+#else
+#define COLOG_WARN(logger, ...) COLOG_DISABLED_LOG()
+#endif
+
+#if COLOG_ACTIVE_LEVEL <= COLOG_LEVEL_ERROR
+#define COLOG_ERROR(logger, ...) COLOG_LOG(logger, ::CoLog::LogLevel::Error, __VA_ARGS__)
+#else
+#define COLOG_ERROR(logger, ...) COLOG_DISABLED_LOG()
+#endif
+
+#if COLOG_ACTIVE_LEVEL <= COLOG_LEVEL_CRITICAL
+#define COLOG_CRITICAL(logger, ...) COLOG_LOG(logger, ::CoLog::LogLevel::Critical, __VA_ARGS__)
+#else
+#define COLOG_CRITICAL(logger, ...) COLOG_DISABLED_LOG()
+#endif
+
+#endif  // COLOG_LOG_SITE_H
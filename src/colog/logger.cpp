@@ -5,25 +5,50 @@
 
 namespace CoLog {
 
+namespace {
+
+// Per-thread output buffer, reused so steady-state logging does not allocate
+thread_local std::string t_format_buffer;
+
+}  // namespace
+
 Logger::Logger(std::string name)
     : name_(std::move(name)),
-      formatter_(std::make_shared<PatternFormatter>()) {}
+      config_(new ConfigPtr(std::make_shared<const LoggerConfig>(
+          LoggerConfig{{}, std::make_shared<PatternFormatter>()}))) {}
+
+Logger::~Logger() {
+    // No thread may log through a logger being destroyed, so every
+    // snapshot can go now
+    delete config_.load(std::memory_order_acquire);
+}
 
 void Logger::log(LogLevel level, const std::string& message,
                  std::source_location loc) {
     // Early level filtering (no lock needed for this check)
-    if (level < level_) {
+    if (!should_log(level)) {
         return;
     }
 
     // Create log record
     LogRecord record(level, message, name_, loc);
 
-    // Format and write to all sinks
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::string formatted = formatter_->format(record);
-
-    for (auto& sink : sinks_) {
+    // Format and write to all sinks of the current snapshot
+    ConfigPtr snapshot = load_config();
+    const LoggerConfig& config = *snapshot;
+
+    std::string& formatted = t_format_buffer;
+    bool is_formatted = false;
+    for (const auto& sink : config.sinks) {
+        if (sink->writes_records()) {
+            sink->write_record(record);
+            continue;
+        }
+        if (!is_formatted) {
+            formatted.clear();
+            config.formatter->format_to(record, formatted);
+            is_formatted = true;
+        }
         sink->write(formatted);
     }
 }
@@ -53,22 +78,45 @@ void Logger::critical(const std::string& message, std::source_location loc) {
 }
 
 void Logger::add_sink(SinkPtr sink) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    sinks_.push_back(std::move(sink));
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    LoggerConfig config = **config_.load(std::memory_order_relaxed);
+    config.sinks.push_back(std::move(sink));
+    replace_config(std::move(config));
 }
 
 void Logger::set_formatter(FormatterPtr formatter) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    formatter_ = std::move(formatter);
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    LoggerConfig config = **config_.load(std::memory_order_relaxed);
+    config.formatter = std::move(formatter);
+    replace_config(std::move(config));
+}
+
+Logger::ConfigPtr Logger::load_config() const {
+    EpochGuard guard;
+    return *config_.load(std::memory_order_acquire);
+}
+
+void Logger::replace_config(LoggerConfig config) {
+    EpochManager& epochs = EpochManager::instance();
+
+    // Free earlier snapshots whose readers have all moved on
+    std::erase_if(retired_, [&epochs](const RetiredConfig& retired) {
+        return epochs.quiescent_since(retired.epoch);
+    });
+
+    const ConfigPtr* previous = config_.exchange(
+        new ConfigPtr(std::make_shared<const LoggerConfig>(std::move(config))),
+        std::memory_order_acq_rel);
+    retired_.push_back({std::unique_ptr<const ConfigPtr>(previous), epochs.advance()});
 }
 
 void Logger::set_level(LogLevel level) {
-    level_ = level;
+    level_.store(level, std::memory_order_relaxed);
 }
 
 void Logger::flush() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (auto& sink : sinks_) {
+    ConfigPtr config = load_config();
+    for (const auto& sink : config->sinks) {
         sink->flush();
     }
 }
@@ -1,28 +1,48 @@
 #ifndef COLOG_LOGGER_H
 #define COLOG_LOGGER_H
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <source_location>
 #include <string>
 #include <vector>
 
+#include "async/epoch.h"
+#include "format.h"
 #include "formatter.h"
 #include "level.h"
 #include "sink.h"
 
 namespace CoLog {
 
+// Immutable output configuration of a Logger. Replaced as a whole on every
+// change, so the log path reads it without locking.
+struct LoggerConfig {
+    std::vector<SinkPtr> sinks;
+    FormatterPtr formatter;
+};
+
+// Synchronous logger: formats and writes on the calling thread.
+//
+// The log path takes no logger lock. It loads the level with a relaxed
+// atomic read and takes a reference on the current LoggerConfig under an
+// EpochGuard, then formats and writes without the pin, so a sink stuck on
+// slow I/O never holds back reclamation elsewhere. add_sink() and
+// set_formatter() publish a new snapshot and retire the old handle once no
+// thread can still be copying it. Sinks serialize their own writes, and
+// the formatter is called concurrently from all logging threads.
 class Logger {
 public:
     explicit Logger(std::string name);
-    ~Logger() = default;
+    ~Logger();
 
-    // Non-copyable, movable
+    // Non-copyable, non-movable (logging threads hold the config snapshot)
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
-    Logger(Logger&&) = default;
-    Logger& operator=(Logger&&) = default;
+    Logger(Logger&&) = delete;
+    Logger& operator=(Logger&&) = delete;
 
     // Core logging method
     void log(LogLevel level, const std::string& message,
@@ -42,6 +62,41 @@ public:
     void critical(const std::string& message,
                   std::source_location loc = std::source_location::current());
 
+    // Format-string logging: logger->info("req {} took {}us", id, us).
+    // The message is only built if the level passes the filter.
+    template <FormatArgument... Args>
+    void log(LogLevel level, FormatString<Args...> fmt, const Args&... args) {
+        if (!should_log(level)) {
+            return;
+        }
+        log(level, CoLog::format(fmt.get(), args...), fmt.location());
+    }
+
+    template <FormatArgument... Args>
+    void trace(FormatString<Args...> fmt, const Args&... args) {
+        log(LogLevel::Trace, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    void debug(FormatString<Args...> fmt, const Args&... args) {
+        log(LogLevel::Debug, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    void info(FormatString<Args...> fmt, const Args&... args) {
+        log(LogLevel::Info, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    void warn(FormatString<Args...> fmt, const Args&... args) {
+        log(LogLevel::Warn, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    void error(FormatString<Args...> fmt, const Args&... args) {
+        log(LogLevel::Error, fmt, args...);
+    }
+    template <FormatArgument... Args>
+    void critical(FormatString<Args...> fmt, const Args&... args) {
+        log(LogLevel::Critical, fmt, args...);
+    }
+
     // Configuration
     void add_sink(SinkPtr sink);
     void set_formatter(FormatterPtr formatter);
@@ -49,17 +104,40 @@ public:
 
     // Accessors
     const std::string& name() const { return name_; }
-    LogLevel level() const { return level_; }
+    LogLevel level() const { return level_.load(std::memory_order_relaxed); }
+
+    // True if a call at `level` would be logged; constant-folds to false
+    // below COLOG_ACTIVE_LEVEL
+    bool should_log(LogLevel level) const {
+        return is_active(level) && level >= level_.load(std::memory_order_relaxed);
+    }
 
     // Flush all sinks
     void flush();
 
 private:
+    using ConfigPtr = std::shared_ptr<const LoggerConfig>;
+
+    // A replaced snapshot handle waiting for its epoch grace period
+    struct RetiredConfig {
+        std::unique_ptr<const ConfigPtr> config;
+        std::uint64_t epoch;
+    };
+
+    // Reference to the current snapshot; pins the epoch only while copying
+    ConfigPtr load_config() const;
+
+    // Publish `config` and retire the previous snapshot; caller holds config_mutex_
+    void replace_config(LoggerConfig config);
+
     std::string name_;
-    LogLevel level_ = LogLevel::Trace;
-    std::vector<SinkPtr> sinks_;
-    FormatterPtr formatter_;
-    std::mutex mutex_;
+    std::atomic<LogLevel> level_{LogLevel::Trace};
+
+    // Handle of the current snapshot. The handle is epoch-protected; the
+    // snapshot itself lives as long as any log call still uses it.
+    std::atomic<const ConfigPtr*> config_;
+    std::mutex config_mutex_;  // Serializes writers only
+    std::vector<RetiredConfig> retired_;
 };
 
 using LoggerPtr = std::shared_ptr<Logger>;
@@ -0,0 +1,286 @@
+#include "mmap_file_sink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "async/async_backend.h"
+
+namespace CoLog {
+
+namespace {
+
+[[noreturn]] void throw_errno(const std::string& what, const std::string& filename) {
+    throw std::runtime_error(what + " " + filename + ": " + std::strerror(errno));
+}
+
+std::size_t page_size() {
+    static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+constexpr std::uint64_t kLengthMagic = 0x4E454C474F4C4F43;  // "COLOGLEN"
+
+std::string length_path(const std::string& filename) {
+    return filename + ".len";
+}
+
+// Written size left in the sidecar by a sink that did not close cleanly,
+// or `size` if there is none
+std::uint64_t recorded_length(const std::string& filename, std::uint64_t size) {
+    int fd = ::open(length_path(filename).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return size;
+    }
+    std::uint64_t record[2] = {};
+    ssize_t n = ::pread(fd, record, sizeof(record), 0);
+    ::close(fd);
+    if (n != static_cast<ssize_t>(sizeof(record)) || record[0] != kLengthMagic) {
+        return size;
+    }
+    return std::min(record[1], size);
+}
+
+// True if the file holds only zero bytes in [begin, end): the untouched
+// preallocated tail. Anything else means the sidecar is stale.
+bool zero_range(int fd, std::uint64_t begin, std::uint64_t end) {
+    char buffer[64 * 1024];
+    while (begin < end) {
+        auto chunk = static_cast<std::size_t>(std::min<std::uint64_t>(sizeof(buffer), end - begin));
+        ssize_t n = ::pread(fd, buffer, chunk, static_cast<off_t>(begin));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;  // Cannot tell; keep everything
+        }
+        auto read = static_cast<std::size_t>(n);
+        if (std::any_of(buffer, buffer + read, [](char c) { return c != 0; })) {
+            return false;
+        }
+        begin += read;
+    }
+    return true;
+}
+
+int advice_flag(MmapAdvice advice) {
+    switch (advice) {
+        case MmapAdvice::Sequential:
+            return MADV_SEQUENTIAL;
+        case MmapAdvice::WillNeed:
+            return MADV_WILLNEED;
+        default:
+            return MADV_NORMAL;
+    }
+}
+
+}  // namespace
+
+MmapFileSink::MmapFileSink(const std::string& filename, bool append,
+                           std::size_t segment_size, MmapSync sync, MmapAdvice advice,
+                           Compression compress_on_close)
+    : filename_(filename), sync_(sync), advice_(advice), compress_on_close_(compress_on_close) {
+    require_compression(compress_on_close_, filename);
+
+    // Segments must start on page boundaries
+    std::size_t page = page_size();
+    segment_size_ = std::max(page, (segment_size + page - 1) / page * page);
+
+    int flags = O_RDWR | O_CREAT | O_CLOEXEC | (append ? 0 : O_TRUNC);
+    fd_ = ::open(filename.c_str(), flags, 0644);
+    if (fd_ < 0) {
+        throw_errno("Failed to open log file", filename);
+    }
+
+    struct stat st{};
+    if (::fstat(fd_, &st) != 0) {
+        int error = errno;
+        ::close(fd_);
+        errno = error;
+        throw_errno("Failed to stat log file", filename);
+    }
+
+    // Continue after existing content, dropping the zero tail a crash
+    // left behind; the first segment starts at the page containing the
+    // end of the data
+    auto end = static_cast<std::uint64_t>(st.st_size);
+    try {
+        std::uint64_t length = append ? recorded_length(filename, end) : end;
+        if (length != end && zero_range(fd_, length, end)) {
+            if (::ftruncate(fd_, static_cast<off_t>(length)) != 0) {
+                throw_errno("Failed to trim log file", filename);
+            }
+            end = length;
+        }
+        open_length_record(end);
+        map_segment(end / page * page);
+    } catch (...) {
+        if (length_ != nullptr) {
+            ::munmap(length_, sizeof(LengthRecord));
+        }
+        if (length_fd_ >= 0) {
+            ::close(length_fd_);
+        }
+        ::close(fd_);
+        throw;
+    }
+    segment_used_ = static_cast<std::size_t>(end - segment_base_);
+    synced_ = segment_used_;
+}
+
+MmapFileSink::~MmapFileSink() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::uint64_t end = segment_base_ + segment_used_;
+    if (sync_ != MmapSync::None) {
+        sync_dirty(MS_SYNC);
+    }
+    unmap_segment();
+    // Drop the unused, preallocated part of the last segment; the file is
+    // then exact and the sidecar can go
+    bool complete = ::ftruncate(fd_, static_cast<off_t>(end)) == 0;
+    if (complete) {
+        ::unlink(length_path(filename_).c_str());
+    }
+    ::munmap(length_, sizeof(LengthRecord));
+    ::close(length_fd_);
+    ::close(fd_);
+    // Still ending in preallocated zeros if the truncate failed
+    if (complete) {
+        AsyncBackend::compress_closed_file(filename_, compress_on_close_);
+    }
+}
+
+void MmapFileSink::write(std::string_view message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(message);
+}
+
+void MmapFileSink::write_batch(std::span<const std::string_view> messages) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::string_view message : messages) {
+        append(message);
+    }
+}
+
+void MmapFileSink::append(std::string_view message) {
+    while (!message.empty()) {
+        if (segment_used_ == segment_size_) {
+            // Roll: hand the full segment to the kernel and map the next one
+            if (sync_ != MmapSync::None) {
+                sync_dirty(MS_ASYNC);
+            }
+            std::uint64_t next = segment_base_ + segment_size_;
+            unmap_segment();
+            map_segment(next);
+        }
+        std::size_t n = std::min(message.size(), segment_size_ - segment_used_);
+        std::memcpy(segment_ + segment_used_, message.data(), n);
+        segment_used_ += n;
+        message.remove_prefix(n);
+    }
+    length_->length = segment_base_ + segment_used_;
+}
+
+void MmapFileSink::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sync_ == MmapSync::Sync) {
+        sync_dirty(MS_SYNC);
+    } else if (sync_ == MmapSync::Async) {
+        sync_dirty(MS_ASYNC);
+    }
+}
+
+void MmapFileSink::on_batch_end() {
+    if (sync_ != MmapSync::Async) {
+        return;  // The page cache already holds everything we wrote
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    sync_dirty(MS_ASYNC);
+}
+
+std::uint64_t MmapFileSink::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segment_base_ + segment_used_;
+}
+
+void MmapFileSink::map_segment(std::uint64_t base) {
+    auto end = static_cast<off_t>(base + segment_size_);
+
+    // Reserve the blocks up front so a full disk shows up here (as an
+    // exception) rather than as SIGBUS on a later memcpy
+#if defined(__linux__)
+    int error = ::posix_fallocate(fd_, static_cast<off_t>(base),
+                                  static_cast<off_t>(segment_size_));
+    if (error == EOPNOTSUPP || error == EINVAL) {
+        error = ::ftruncate(fd_, end) == 0 ? 0 : errno;
+    }
+    if (error != 0) {
+        errno = error;
+        throw_errno("Failed to allocate log segment in", filename_);
+    }
+#else
+    struct stat st{};
+    if (::fstat(fd_, &st) == 0 && st.st_size < end && ::ftruncate(fd_, end) != 0) {
+        throw_errno("Failed to allocate log segment in", filename_);
+    }
+#endif
+
+    void* ptr = ::mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                       static_cast<off_t>(base));
+    if (ptr == MAP_FAILED) {
+        throw_errno("Failed to map log segment in", filename_);
+    }
+    if (advice_ != MmapAdvice::Normal) {
+        ::madvise(ptr, segment_size_, advice_flag(advice_));
+    }
+
+    segment_ = static_cast<char*>(ptr);
+    segment_base_ = base;
+    segment_used_ = 0;
+    synced_ = 0;
+}
+
+void MmapFileSink::unmap_segment() {
+    if (segment_ != nullptr) {
+        ::munmap(segment_, segment_size_);
+        segment_ = nullptr;
+    }
+}
+
+void MmapFileSink::sync_dirty(int flags) {
+    if (segment_ == nullptr || synced_ == segment_used_) {
+        return;
+    }
+    // msync needs a page-aligned start
+    std::size_t begin = synced_ / page_size() * page_size();
+    ::msync(segment_ + begin, segment_used_ - begin, flags);
+    ::msync(length_, sizeof(LengthRecord), flags);
+    synced_ = segment_used_;
+}
+
+void MmapFileSink::open_length_record(std::uint64_t length) {
+    std::string path = length_path(filename_);
+    length_fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (length_fd_ < 0) {
+        throw_errno("Failed to open length file", path);
+    }
+    if (::ftruncate(length_fd_, sizeof(LengthRecord)) != 0) {
+        throw_errno("Failed to size length file", path);
+    }
+    void* ptr = ::mmap(nullptr, sizeof(LengthRecord), PROT_READ | PROT_WRITE, MAP_SHARED,
+                       length_fd_, 0);
+    if (ptr == MAP_FAILED) {
+        throw_errno("Failed to map length file", path);
+    }
+    length_ = static_cast<LengthRecord*>(ptr);
+    length_->magic = kLengthMagic;
+    length_->length = length;
+}
+
+}  // namespace CoLog
@@ -0,0 +1,101 @@
+#ifndef COLOG_MMAP_FILE_SINK_H
+#define COLOG_MMAP_FILE_SINK_H
+
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+
+#include "compression.h"
+#include "sink.h"
+
+namespace CoLog {
+
+// When MmapFileSink asks the kernel to write dirty pages back.
+enum class MmapSync {
+    None,   // Leave it to the page cache (survives a process crash, not a power loss)
+    Async,  // msync(MS_ASYNC) at the end of each backend batch and on flush()
+    Sync    // msync(MS_SYNC) on flush()
+};
+
+// Access pattern MmapFileSink passes to madvise() for each mapped segment.
+enum class MmapAdvice {
+    Normal,      // No advice; the kernel's default readahead
+    Sequential,  // MADV_SEQUENTIAL: pages are written once, in order
+    WillNeed     // MADV_WILLNEED: fault the whole segment in when it is mapped
+};
+
+// File sink that copies messages straight into a memory-mapped segment of
+// the log file. Each segment is preallocated and mapped once; writing a
+// message is a memcpy plus a tail advance, and rolling to the next segment
+// is the only syscall on the write path. Because the data lives in the
+// page cache, everything written survives a process crash.
+//
+// The preallocated tail of the current segment reads as zero bytes until
+// the sink is destroyed, when the file is truncated to the written size.
+// Meanwhile the written size is kept in a small mapped sidecar file,
+// `<filename>.len`, which is removed on destruction. If the process dies
+// first, the next sink opened on the file with append finds the sidecar
+// and trims the file back to that size, provided everything past it is
+// still zero; data the sink wrote, NUL bytes included, is never cut.
+//
+// With `compress_on_close` set, the finished (truncated) file is handed to
+// the AsyncBackend's FileCompressor when the sink is destroyed.
+class MmapFileSink : public ISink {
+public:
+    static constexpr std::size_t kDefaultSegmentSize = 64 * 1024 * 1024;
+
+    explicit MmapFileSink(const std::string& filename, bool append = true,
+                          std::size_t segment_size = kDefaultSegmentSize,
+                          MmapSync sync = MmapSync::None,
+                          MmapAdvice advice = MmapAdvice::Sequential,
+                          Compression compress_on_close = Compression::None);
+    ~MmapFileSink() override;
+
+    // Non-copyable
+    MmapFileSink(const MmapFileSink&) = delete;
+    MmapFileSink& operator=(const MmapFileSink&) = delete;
+
+    void write(std::string_view message) override;
+    void write_batch(std::span<const std::string_view> messages) override;
+    void flush() override;
+    void on_batch_end() override;
+
+    // Bytes written to the file so far (including pre-existing content)
+    std::uint64_t size() const;
+
+private:
+    // write() without the lock; the caller holds mutex_
+    void append(std::string_view message);
+
+    void map_segment(std::uint64_t base);
+    void unmap_segment();
+    void sync_dirty(int flags);
+    void open_length_record(std::uint64_t length);
+
+    int fd_ = -1;
+    std::string filename_;
+    std::size_t segment_size_;
+    MmapSync sync_;
+    MmapAdvice advice_;
+    Compression compress_on_close_;
+
+    // Written size, mapped from the sidecar file
+    struct LengthRecord {
+        std::uint64_t magic;
+        std::uint64_t length;
+    };
+    int length_fd_ = -1;
+    LengthRecord* length_ = nullptr;
+
+    char* segment_ = nullptr;
+    std::uint64_t segment_base_ = 0;   // File offset of segment_[0]
+    std::size_t segment_used_ = 0;     // Bytes written into the segment
+    std::size_t synced_ = 0;           // Segment bytes already msync'ed
+
+    mutable std::mutex mutex_;
+};
+
+}  // namespace CoLog
+
+#endif  // COLOG_MMAP_FILE_SINK_H
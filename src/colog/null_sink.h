@@ -20,6 +20,10 @@ public:
         // Intentionally empty - discard all output
     }
 
+    void write_batch(std::span<const std::string_view> /*messages*/) override {
+        // Skip the per-message default as well
+    }
+
     void flush() override {
         // Nothing to flush
     }
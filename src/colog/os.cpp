@@ -0,0 +1,113 @@
+#include "os.h"
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace CoLog {
+
+namespace {
+
+std::uint64_t query_thread_id() {
+#if defined(__linux__)
+    return static_cast<std::uint64_t>(::syscall(SYS_gettid));
+#else
+    return static_cast<std::uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+#endif
+}
+
+#if !defined(__linux__) && !defined(_WIN32)
+// Fallback for futex_wait(): one condition variable for all words; waiters
+// re-check their word under the mutex, so a wake cannot slip between the
+// check and the wait
+std::mutex g_futex_mutex;
+std::condition_variable g_futex_cv;
+#endif
+
+}  // namespace
+
+std::uint64_t current_thread_id() {
+    thread_local const std::uint64_t id = query_thread_id();
+    return id;
+}
+
+void lower_current_thread_priority() {
+#if defined(__linux__)
+    // On Linux nice values and I/O priorities apply per thread
+    auto tid = static_cast<id_t>(current_thread_id());
+    ::setpriority(PRIO_PROCESS, tid, 19);
+    constexpr int kIoprioWhoProcess = 1;
+    constexpr int kIoprioClassIdle = 3;
+    ::syscall(SYS_ioprio_set, kIoprioWhoProcess, static_cast<int>(tid), kIoprioClassIdle << 13);
+#elif defined(_WIN32)
+    ::SetThreadPriority(::GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#endif
+}
+
+void futex_wait(const std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                std::chrono::microseconds timeout) {
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+    const bool forever = timeout == std::chrono::microseconds::max();
+#if defined(__linux__)
+    timespec relative{};
+    if (!forever) {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+        relative.tv_sec = static_cast<time_t>(seconds.count());
+        relative.tv_nsec = static_cast<long>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - seconds).count());
+    }
+    ::syscall(SYS_futex, &word, FUTEX_WAIT_PRIVATE, expected, forever ? nullptr : &relative,
+              nullptr, 0);
+#elif defined(_WIN32)
+    DWORD milliseconds = INFINITE;
+    if (!forever) {
+        // Round up, so short waits do not turn into busy polling
+        auto rounded = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+        milliseconds = static_cast<DWORD>(std::min<long long>(rounded, INFINITE - 1));
+    }
+    ::WaitOnAddress(const_cast<std::atomic<std::uint32_t>*>(&word), &expected,
+                    sizeof(expected), milliseconds);
+#else
+    std::unique_lock<std::mutex> lock(g_futex_mutex);
+    auto changed = [&] { return word.load(std::memory_order_acquire) != expected; };
+    if (forever) {
+        g_futex_cv.wait(lock, changed);
+    } else {
+        g_futex_cv.wait_for(lock, timeout, changed);
+    }
+#endif
+}
+
+void futex_wake_all(std::atomic<std::uint32_t>& word) {
+#if defined(__linux__)
+    ::syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#elif defined(_WIN32)
+    ::WakeByAddressAll(&word);
+#else
+    (void)word;
+    std::lock_guard<std::mutex> lock(g_futex_mutex);
+    g_futex_cv.notify_all();
+#endif
+}
+
+}  // namespace CoLog
@@ -0,0 +1,30 @@
+#ifndef COLOG_OS_H
+#define COLOG_OS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace CoLog {
+
+// Numeric id of the calling thread (the kernel tid on Linux), cached per
+// thread so it is cheap enough to capture on every log call.
+std::uint64_t current_thread_id();
+
+// Drop the calling thread to the lowest CPU priority (and idle I/O class
+// on Linux), for background housekeeping threads. Best effort.
+void lower_current_thread_priority();
+
+// Sleep while `word` still holds `expected`, for at most `timeout`
+// (microseconds::max() waits indefinitely). A futex on Linux and
+// WaitOnAddress on Windows; elsewhere a process-wide condition variable.
+// May return early or spuriously, so callers re-check their condition.
+void futex_wait(const std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                std::chrono::microseconds timeout);
+
+// Wake every thread in futex_wait() on `word`. Change the word first.
+void futex_wake_all(std::atomic<std::uint32_t>& word);
+
+}  // namespace CoLog
+
+#endif  // COLOG_OS_H
@@ -1,41 +1,346 @@
 #include "pattern_formatter.h"
 
+#include <atomic>
+#include <charconv>
 #include <chrono>
 #include <ctime>
-#include <iomanip>
-#include <sstream>
+#include <limits>
 
 namespace CoLog {
 
-std::string PatternFormatter::format(const LogRecord& record) {
-    std::ostringstream oss;
+namespace detail {
+
+// Everything a step may read while formatting one record
+struct PatternContext {
+    const LogRecord& record;
+    const std::tm* local_time;  // Only set while rendering the date/time text
+    std::uint32_t nanos;        // Sub-second part of the timestamp
+    std::string_view literals;
+    std::string_view time_text;  // Rendered date/time runs for this second
+};
+
+}  // namespace detail
+
+namespace {
+
+using detail::PatternContext;
+using detail::PatternStep;
+
+/**
+ * @brief Per-thread cache of the broken-down local time.
+ *
+ * Keyed by the epoch second at which the cached local minute starts, so
+ * within a minute only tm_sec is patched; zones with odd (sub-minute) UTC
+ * offsets are still handled correctly and DST changes are picked up
+ * within a minute.
+ */
+struct TimeCache {
+    std::int64_t minute_start = std::numeric_limits<std::int64_t>::min();
+    std::int64_t second = std::numeric_limits<std::int64_t>::min();
+    std::tm tm{};
+};
+
+thread_local TimeCache t_time_cache;
+
+/**
+ * @brief Per-thread cache of a formatter's rendered date/time runs.
+ *
+ * Holds the text for one formatter and one epoch second; a thread that
+ * alternates between formatters re-renders (but still reuses TimeCache).
+ */
+struct TimeTextCache {
+    std::uint64_t formatter = 0;  // PatternFormatter id; 0 = empty
+    std::int64_t second = std::numeric_limits<std::int64_t>::min();
+    std::string text;
+};
+
+thread_local TimeTextCache t_time_text_cache;
+
+std::atomic<std::uint64_t> g_next_formatter_id{1};
 
-    // Format timestamp: [2024-01-01 12:00:00.123]
-    auto time_t_val = std::chrono::system_clock::to_time_t(record.timestamp);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                  record.timestamp.time_since_epoch()) %
-              1000;
+const std::tm& local_time(std::int64_t seconds) {
+    TimeCache& cache = t_time_cache;
+    if (seconds == cache.second) {
+        return cache.tm;
+    }
 
-    std::tm tm_buf{};
+    // Unsigned so the initial sentinel cannot overflow
+    std::uint64_t offset = static_cast<std::uint64_t>(seconds) -
+                           static_cast<std::uint64_t>(cache.minute_start);
+    if (offset < 60) {
+        cache.tm.tm_sec = static_cast<int>(offset);
+    } else {
+        auto time_t_val = static_cast<std::time_t>(seconds);
 #ifdef _WIN32
-    localtime_s(&tm_buf, &time_t_val);
+        localtime_s(&cache.tm, &time_t_val);
 #else
-    localtime_r(&time_t_val, &tm_buf);
+        localtime_r(&time_t_val, &cache.tm);
 #endif
+        cache.minute_start = seconds - cache.tm.tm_sec;
+    }
+    cache.second = seconds;
+    return cache.tm;
+}
+
+inline void append_digits(std::string& dest, unsigned value, int width) {
+    char buffer[10];
+    for (int i = width - 1; i >= 0; --i) {
+        buffer[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    dest.append(buffer, static_cast<std::size_t>(width));
+}
+
+inline void append_number(std::string& dest, std::uint64_t value) {
+    char buffer[20];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    dest.append(buffer, static_cast<std::size_t>(end - buffer));
+}
+
+std::string_view file_basename(std::string_view path) {
+    std::size_t slash = path.find_last_of("/\\");
+    return slash == std::string_view::npos ? path : path.substr(slash + 1);
+}
+
+// --- Step writers ---
+
+void write_literal(const PatternContext& c, const PatternStep& s, std::string& dest) {
+    dest.append(c.literals.data() + s.offset, s.length);
+}
 
-    oss << '[' << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S") << '.'
-        << std::setfill('0') << std::setw(3) << ms.count() << "] ";
+void write_time_run(const PatternContext& c, const PatternStep& s, std::string& dest) {
+    dest.append(c.time_text.data() + s.offset, s.length);
+}
+
+void write_year(const PatternContext& c, const PatternStep&, std::string& dest) {
+    append_digits(dest, static_cast<unsigned>(c.local_time->tm_year + 1900), 4);
+}
+
+void write_month(const PatternContext& c, const PatternStep&, std::string& dest) {
+    append_digits(dest, static_cast<unsigned>(c.local_time->tm_mon + 1), 2);
+}
+
+void write_day(const PatternContext& c, const PatternStep&, std::string& dest) {
+    append_digits(dest, static_cast<unsigned>(c.local_time->tm_mday), 2);
+}
+
+void write_hour(const PatternContext& c, const PatternStep&, std::string& dest) {
+    append_digits(dest, static_cast<unsigned>(c.local_time->tm_hour), 2);
+}
+
+void write_minute(const PatternContext& c, const PatternStep&, std::string& dest) {
+    append_digits(dest, static_cast<unsigned>(c.local_time->tm_min), 2);
+}
+
+void write_second(const PatternContext& c, const PatternStep&, std::string& dest) {
+    append_digits(dest, static_cast<unsigned>(c.local_time->tm_sec), 2);
+}
+
+void write_millis(const PatternContext& c, const PatternStep&, std::string& dest) {
+    append_digits(dest, c.nanos / 1000000, 3);
+}
 
-    // Format level: [INFO]
-    oss << '[' << to_string(record.level) << "] ";
+void write_micros(const PatternContext& c, const PatternStep&, std::string& dest) {
+    append_digits(dest, c.nanos / 1000, 6);
+}
+
+void write_nanos(const PatternContext& c, const PatternStep&, std::string& dest) {
+    append_digits(dest, c.nanos, 9);
+}
+
+void write_level(const PatternContext& c, const PatternStep&, std::string& dest) {
+    dest.append(to_string(c.record.level));
+}
+
+void write_level_letter(const PatternContext& c, const PatternStep&, std::string& dest) {
+    dest.push_back(to_string(c.record.level).front());
+}
+
+void write_name(const PatternContext& c, const PatternStep&, std::string& dest) {
+    dest.append(c.record.logger_name);
+}
+
+void write_message(const PatternContext& c, const PatternStep&, std::string& dest) {
+    dest.append(c.record.message);
+}
+
+void write_file(const PatternContext& c, const PatternStep&, std::string& dest) {
+    dest.append(file_basename(c.record.location.file_name()));
+}
+
+void write_path(const PatternContext& c, const PatternStep&, std::string& dest) {
+    dest.append(c.record.location.file_name());
+}
+
+void write_line(const PatternContext& c, const PatternStep&, std::string& dest) {
+    append_number(dest, c.record.location.line());
+}
+
+void write_function(const PatternContext& c, const PatternStep&, std::string& dest) {
+    dest.append(c.record.location.function_name());
+}
+
+void write_thread(const PatternContext& c, const PatternStep&, std::string& dest) {
+    append_number(dest, c.record.thread_id);
+}
+
+struct FlagInfo {
+    PatternStep::Writer write;
+    std::uint32_t time_width;  // Rendered width of date/time flags, 0 otherwise
+};
+
+// Returns {nullptr, 0} for unknown flags
+FlagInfo lookup_flag(char flag) {
+    switch (flag) {
+        case 'Y': return {write_year, 4};
+        case 'm': return {write_month, 2};
+        case 'd': return {write_day, 2};
+        case 'H': return {write_hour, 2};
+        case 'M': return {write_minute, 2};
+        case 'S': return {write_second, 2};
+        case 'e': return {write_millis, 0};
+        case 'f': return {write_micros, 0};
+        case 'F': return {write_nanos, 0};
+        case 'l': return {write_level, 0};
+        case 'L': return {write_level_letter, 0};
+        case 'n': return {write_name, 0};
+        case 'v': return {write_message, 0};
+        case 's': return {write_file, 0};
+        case 'g': return {write_path, 0};
+        case '#': return {write_line, 0};
+        case '!': return {write_function, 0};
+        case 't': return {write_thread, 0};
+        default: return {nullptr, 0};
+    }
+}
+
+// Date/time flag steps carry their width in `length`; other flags carry 0
+bool is_time_flag(const PatternStep& step) {
+    return step.write != write_literal && step.length > 0;
+}
+
+}  // namespace
+
+PatternFormatter::PatternFormatter(std::string pattern)
+    : pattern_(std::move(pattern)),
+      id_(g_next_formatter_id.fetch_add(1, std::memory_order_relaxed)) {
+    compile();
+}
+
+void PatternFormatter::add_literal(std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    // Extend the previous literal step rather than adding a new one
+    if (!steps_.empty() && steps_.back().write == write_literal &&
+        steps_.back().offset + steps_.back().length == literals_.size()) {
+        steps_.back().length += static_cast<std::uint32_t>(text.size());
+    } else {
+        steps_.push_back({write_literal, static_cast<std::uint32_t>(literals_.size()),
+                          static_cast<std::uint32_t>(text.size())});
+    }
+    literals_.append(text);
+}
+
+void PatternFormatter::compile() {
+    std::string_view pattern = pattern_;
+    std::size_t literal_start = 0;
+
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern[i] != '%') {
+            continue;
+        }
+        add_literal(pattern.substr(literal_start, i - literal_start));
+
+        if (i + 1 == pattern.size()) {
+            // Trailing '%': keep it
+            add_literal("%");
+            literal_start = pattern.size();
+            break;
+        }
+
+        char flag = pattern[++i];
+        FlagInfo info = lookup_flag(flag);
+        if (info.write != nullptr) {
+            steps_.push_back({info.write, 0, info.time_width});
+        } else if (flag == '%') {
+            add_literal("%");
+        } else {
+            add_literal(pattern.substr(i - 1, 2));
+        }
+        literal_start = i + 1;
+    }
+    add_literal(pattern.substr(literal_start));
+    add_literal("\n");
+    merge_time_runs();
+}
+
+void PatternFormatter::merge_time_runs() {
+    std::vector<PatternStep> merged;
+    std::size_t i = 0;
+    while (i < steps_.size()) {
+        // A run is a maximal stretch of literals and date/time flags
+        // holding at least one flag; lone literals stay as they are
+        std::size_t end = i;
+        bool has_time = false;
+        while (end < steps_.size() &&
+               (steps_[end].write == write_literal || is_time_flag(steps_[end]))) {
+            has_time = has_time || is_time_flag(steps_[end]);
+            ++end;
+        }
+        if (!has_time) {
+            merged.push_back(steps_[i]);
+            ++i;
+            continue;
+        }
+
+        auto offset = static_cast<std::uint32_t>(time_text_size_);
+        for (; i < end; ++i) {
+            time_steps_.push_back(steps_[i]);
+            time_text_size_ += steps_[i].length;
+        }
+        merged.push_back({write_time_run, offset,
+                          static_cast<std::uint32_t>(time_text_size_ - offset)});
+    }
+    steps_ = std::move(merged);
+}
+
+void PatternFormatter::render_time_text(const LogRecord& record, std::int64_t seconds,
+                                        std::string& text) const {
+    PatternContext context{record, &local_time(seconds), 0, literals_, {}};
+    text.clear();
+    for (const PatternStep& step : time_steps_) {
+        step.write(context, step, text);
+    }
+}
+
+std::string PatternFormatter::format(const LogRecord& record) {
+    std::string out;
+    format_to(record, out);
+    return out;
+}
 
-    // Format logger name: [main]
-    oss << '[' << record.logger_name << "] ";
+void PatternFormatter::format_to(const LogRecord& record, std::string& dest) {
+    auto since_epoch = record.timestamp.time_since_epoch();
+    auto seconds = std::chrono::floor<std::chrono::seconds>(since_epoch);
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - seconds);
 
-    // Message
-    oss << record.message << '\n';
+    std::string_view time_text;
+    if (time_text_size_ > 0) {
+        TimeTextCache& cache = t_time_text_cache;
+        if (cache.formatter != id_ || cache.second != seconds.count()) {
+            render_time_text(record, seconds.count(), cache.text);
+            cache.formatter = id_;
+            cache.second = seconds.count();
+        }
+        time_text = cache.text;
+    }
 
-    return oss.str();
+    PatternContext context{record, nullptr, static_cast<std::uint32_t>(nanos.count()),
+                           literals_, time_text};
+    for (const PatternStep& step : steps_) {
+        step.write(context, step, dest);
+    }
 }
 
 }  // namespace CoLog
@@ -1,18 +1,76 @@
 #ifndef COLOG_PATTERN_FORMATTER_H
 #define COLOG_PATTERN_FORMATTER_H
 
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include "formatter.h"
 
 namespace CoLog {
 
-// PatternFormatter formats log records as:
+namespace detail {
+
+struct PatternContext;
+
+// One compiled piece of a pattern: a flag writer, a literal run stored in
+// the formatter's literal buffer, or a run of date/time flags and literals
+// copied from the per-thread cached text.
+struct PatternStep {
+    using Writer = void (*)(const PatternContext& context, const PatternStep& step,
+                            std::string& dest);
+
+    Writer write;
+    std::uint32_t offset;  // Into the literal buffer or the cached date/time text
+    std::uint32_t length;  // Text length; for date/time flags, their rendered width
+};
+
+}  // namespace detail
+
+// PatternFormatter formats log records according to a pattern string with
+// spdlog-style flags. The default pattern produces:
 // [2024-01-01 12:00:00.123] [INFO] [logger_name] message
+//
+// Supported flags:
+//   %Y year        %m month      %d day        %H hour      %M minute
+//   %S second      %e millis     %f micros     %F nanos
+//   %l level       %L level letter             %n logger name
+//   %v message     %s source file name         %g source file path
+//   %# line        %! function   %t thread id  %% literal '%'
+//
+// The pattern is compiled once into a list of steps, so formatting is a
+// linear walk with no parsing. Each run of consecutive date/time flags and
+// literals ("[%Y-%m-%d %H:%M:%S." in the default pattern) becomes a single
+// step whose text is rendered once per second and cached per thread, so
+// only %e/%f/%F and the record's own fields are formatted per record.
+// localtime_r runs at most once per minute; unknown flags are copied
+// through verbatim.
 class PatternFormatter : public IFormatter {
 public:
-    PatternFormatter() = default;
+    static constexpr std::string_view kDefaultPattern = "[%Y-%m-%d %H:%M:%S.%e] [%l] [%n] %v";
+
+    explicit PatternFormatter(std::string pattern = std::string(kDefaultPattern));
     ~PatternFormatter() override = default;
 
     std::string format(const LogRecord& record) override;
+    void format_to(const LogRecord& record, std::string& dest) override;
+
+    const std::string& pattern() const { return pattern_; }
+
+private:
+    void compile();
+    void add_literal(std::string_view text);
+    void merge_time_runs();
+    void render_time_text(const LogRecord& record, std::int64_t seconds,
+                          std::string& text) const;
+
+    std::string pattern_;
+    std::string literals_;
+    std::vector<detail::PatternStep> steps_;
+    std::vector<detail::PatternStep> time_steps_;  // Flags and literals of all date/time runs
+    std::size_t time_text_size_ = 0;               // Rendered length of time_steps_
+    std::uint64_t id_;                             // Keys the per-thread cache
 };
 
 }  // namespace CoLog
@@ -2,20 +2,36 @@
 #define COLOG_RECORD_H
 
 #include <chrono>
+#include <cstdint>
+#include <cstddef>
 #include <source_location>
-#include <string>
+#include <span>
 #include <string_view>
 
 #include "level.h"
+#include "os.h"
 
 namespace CoLog {
 
+// A log event as seen by formatters. Text fields are views: they refer to
+// the caller's message and logger name (sync path) or to the backend's
+// decode buffers (async path) and are only valid for the formatting call.
 struct LogRecord {
     std::chrono::system_clock::time_point timestamp;
     LogLevel level;
-    std::string message;
-    std::string logger_name;  // Changed from string_view to avoid dangling reference
+    std::string_view message;
+    std::string_view logger_name;
     std::source_location location;
+    std::uint64_t thread_id;  // Thread that made the log call
+
+    // Set by the async backend when formatting was deferred: the call's
+    // format string and its encoded arguments (see format.h). `message`
+    // is empty when the logger's formatter does not need it.
+    const char* format = nullptr;
+    std::span<const std::byte> format_args;
+
+    // SiteRegistry id of the call site (async path only; 0 when unknown)
+    std::uint32_t site_id = 0;
 
     // Default constructor for container compatibility
     LogRecord() 
@@ -23,15 +39,26 @@ struct LogRecord {
           level(LogLevel::Info),
           message(),
           logger_name(),
-          location(std::source_location::current()) {}
+          location(std::source_location::current()),
+          thread_id(current_thread_id()) {}
 
-    LogRecord(LogLevel lvl, std::string msg, std::string_view name,
+    LogRecord(LogLevel lvl, std::string_view msg, std::string_view name,
               std::source_location loc = std::source_location::current())
         : timestamp(std::chrono::system_clock::now()),
           level(lvl),
-          message(std::move(msg)),
+          message(msg),
+          logger_name(name),
+          location(loc),
+          thread_id(current_thread_id()) {}
+
+    LogRecord(std::chrono::system_clock::time_point ts, LogLevel lvl, std::string_view msg,
+              std::string_view name, std::source_location loc, std::uint64_t tid)
+        : timestamp(ts),
+          level(lvl),
+          message(msg),
           logger_name(name),
-          location(loc) {}
+          location(loc),
+          thread_id(tid) {}
 };
 
 }  // namespace CoLog
@@ -1,62 +1,187 @@
 #include "registry.h"
 
+#include "async/epoch.h"
 #include "console_sink.h"
 
 namespace CoLog {
 
+namespace {
+
+/**
+ * @brief Loggers the calling thread has looked up, valid for one registry version.
+ *
+ * Holds weak references: while the version matches, the registry's
+ * snapshot keeps each logger alive, and once a logger is dropped the
+ * cache never delays its destruction.
+ */
+struct RegistryCache {
+    std::uint64_t version = 0;
+    std::unordered_map<std::string, std::weak_ptr<Logger>> loggers;
+    std::weak_ptr<Logger> default_logger;
+
+    // Drop everything if the registry changed since it was filled;
+    // returns true if it did
+    bool sync(std::uint64_t current) {
+        if (version == current) {
+            return false;
+        }
+        loggers.clear();
+        default_logger.reset();
+        version = current;
+        return true;
+    }
+};
+
+thread_local RegistryCache t_registry_cache;
+
+}  // namespace
+
 Registry& Registry::instance() {
     static Registry instance;
     return instance;
 }
 
+Registry::Registry() : snapshot_(new Snapshot()) {}
+
+Registry::~Registry() {
+    delete snapshot_.load(std::memory_order_acquire);
+}
+
 LoggerPtr Registry::get(const std::string& name) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    RegistryCache& cache = t_registry_cache;
+    if (cache.sync(version())) {
+        try_collect_retired();
+    }
+    auto cached = cache.loggers.find(name);
+    if (cached != cache.loggers.end()) {
+        if (LoggerPtr logger = cached->second.lock()) {
+            return logger;
+        }
+    }
+
+    {
+        EpochGuard guard;
+        const Snapshot& snapshot = *snapshot_.load(std::memory_order_acquire);
+        auto it = snapshot.loggers.find(name);
+        if (it != snapshot.loggers.end()) {
+            cache.loggers.insert_or_assign(name, it->second);
+            return it->second;
+        }
+    }
 
-    auto it = loggers_.find(name);
-    if (it != loggers_.end()) {
-        return it->second;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Snapshot& current = *snapshot_.load(std::memory_order_relaxed);
+    auto it = current.loggers.find(name);
+    if (it != current.loggers.end()) {
+        return it->second;  // Created by another thread meanwhile
     }
 
     // Create new logger
     auto logger = std::make_shared<Logger>(name);
-    loggers_[name] = logger;
+    Snapshot next = current;
+    next.loggers.emplace(name, logger);
+    publish(std::move(next));
     return logger;
 }
 
 void Registry::set_default(LoggerPtr logger) {
     std::lock_guard<std::mutex> lock(mutex_);
-    default_logger_ = std::move(logger);
+    Snapshot next = *snapshot_.load(std::memory_order_relaxed);
+    next.default_logger = std::move(logger);
+    publish(std::move(next));
 }
 
 LoggerPtr Registry::get_default() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    RegistryCache& cache = t_registry_cache;
+    if (cache.sync(version())) {
+        try_collect_retired();
+    }
+    if (LoggerPtr logger = cache.default_logger.lock()) {
+        return logger;
+    }
 
-    if (!default_logger_) {
-        // Create a default logger with console sink
-        default_logger_ = std::make_shared<Logger>("default");
-        default_logger_->add_sink(std::make_shared<ConsoleSink>());
-        loggers_["default"] = default_logger_;
+    {
+        EpochGuard guard;
+        const Snapshot& snapshot = *snapshot_.load(std::memory_order_acquire);
+        if (snapshot.default_logger) {
+            cache.default_logger = snapshot.default_logger;
+            return snapshot.default_logger;
+        }
     }
 
-    return default_logger_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Snapshot& current = *snapshot_.load(std::memory_order_relaxed);
+    if (current.default_logger) {
+        return current.default_logger;
+    }
+
+    // Create a default logger with console sink
+    auto logger = std::make_shared<Logger>("default");
+    logger->add_sink(std::make_shared<ConsoleSink>());
+    Snapshot next = current;
+    next.default_logger = logger;
+    next.loggers["default"] = logger;
+    publish(std::move(next));
+    return logger;
 }
 
 void Registry::flush_all() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (auto& [name, logger] : loggers_) {
+    // Take references under the pin and flush without it
+    std::vector<LoggerPtr> loggers;
+    {
+        EpochGuard guard;
+        for (const auto& [name, logger] : snapshot_.load(std::memory_order_acquire)->loggers) {
+            loggers.push_back(logger);
+        }
+    }
+    try_collect_retired();
+    for (const auto& logger : loggers) {
         logger->flush();
     }
 }
 
 void Registry::drop(const std::string& name) {
     std::lock_guard<std::mutex> lock(mutex_);
-    loggers_.erase(name);
+    Snapshot next = *snapshot_.load(std::memory_order_relaxed);
+    if (next.loggers.erase(name) != 0) {
+        publish(std::move(next));
+    }
 }
 
 void Registry::drop_all() {
     std::lock_guard<std::mutex> lock(mutex_);
-    loggers_.clear();
-    default_logger_.reset();
+    publish(Snapshot());
+}
+
+void Registry::publish(Snapshot next) {
+    const Snapshot* previous = snapshot_.exchange(new Snapshot(std::move(next)),
+                                                  std::memory_order_acq_rel);
+    // Bump the version after the new snapshot is visible, so a reader that
+    // sees the new version also finds the new snapshot
+    version_.fetch_add(1, std::memory_order_acq_rel);
+    retired_.push_back(
+        {std::unique_ptr<const Snapshot>(previous), EpochManager::instance().advance()});
+
+    // Usually no reader still holds it, so dropped loggers go right away
+    collect_retired();
+}
+
+void Registry::collect_retired() {
+    EpochManager& epochs = EpochManager::instance();
+    std::erase_if(retired_, [&epochs](const RetiredSnapshot& retired) {
+        return epochs.quiescent_since(retired.epoch);
+    });
+    retired_count_.store(retired_.size(), std::memory_order_release);
+}
+
+void Registry::try_collect_retired() {
+    if (retired_count_.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (lock.owns_lock()) {
+        collect_retired();
+    }
 }
 
 // Convenience free functions
@@ -73,4 +198,3 @@ void set_default_logger(LoggerPtr logger) {
 }
 
 }  // namespace CoLog
-
@@ -1,15 +1,25 @@
 #ifndef COLOG_REGISTRY_H
 #define COLOG_REGISTRY_H
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "logger.h"
 
 namespace CoLog {
 
+// Read-mostly logger registry. The name map is an immutable snapshot that
+// writers (creating, dropping or setting loggers) copy, modify and publish
+// under a mutex; readers never lock. Each thread also caches weak
+// references to the loggers it has looked up, tagged with the registry
+// version, so a repeat get() is one atomic load and a thread-local map
+// lookup. Replaced snapshots are freed as soon as no reader holds them:
+// on publish, or later from get(), get_default() and flush_all().
 class Registry {
 public:
     // Get the singleton instance
@@ -33,17 +43,43 @@ public:
     // Drop all loggers
     void drop_all();
 
+    // Bumped on every change; thread-local caches older than this are stale
+    std::uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
 private:
-    Registry() = default;
-    ~Registry() = default;
+    struct Snapshot {
+        std::unordered_map<std::string, LoggerPtr> loggers;
+        LoggerPtr default_logger;
+    };
+
+    // A replaced snapshot waiting for its epoch grace period
+    struct RetiredSnapshot {
+        std::unique_ptr<const Snapshot> snapshot;
+        std::uint64_t epoch;
+    };
+
+    Registry();
+    ~Registry();
 
     // Non-copyable
     Registry(const Registry&) = delete;
     Registry& operator=(const Registry&) = delete;
 
-    std::unordered_map<std::string, LoggerPtr> loggers_;
-    LoggerPtr default_logger_;
-    std::mutex mutex_;
+    // Publish `next` and retire the current snapshot; caller holds mutex_
+    void publish(Snapshot next);
+
+    // Free retired snapshots whose readers have all moved on; caller holds mutex_
+    void collect_retired();
+
+    // collect_retired() if anything is retired and no writer is busy;
+    // call without an EpochGuard held
+    void try_collect_retired();
+
+    std::atomic<const Snapshot*> snapshot_;
+    std::atomic<std::uint64_t> version_{1};
+    std::vector<RetiredSnapshot> retired_;
+    std::atomic<std::size_t> retired_count_{0};  // retired_.size(), read without mutex_
+    std::mutex mutex_;  // Serializes writers only
 };
 
 // Convenience free functions
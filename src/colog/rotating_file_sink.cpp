@@ -0,0 +1,287 @@
+#include "rotating_file_sink.h"
+
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+#include "async/async_backend.h"
+
+namespace CoLog {
+
+RotatingFileSink::RotatingFileSink(const std::string& filename, RotationConfig config,
+                                   bool append)
+    : filename_(filename),
+      config_(config),
+      writer_(filename, append) {
+    require_compression(config_.compression, filename);
+    if (config_.buffer_size == 0) {
+        config_.buffer_size = 1;
+    }
+    buffer_.reset(new char[config_.buffer_size]);
+
+    std::error_code ec;
+    auto existing = std::filesystem::file_size(filename_, ec);
+    file_size_ = ec ? 0 : existing;
+
+    schedule_next_rotation(std::chrono::system_clock::now());
+    helper_ = std::thread(&RotatingFileSink::helper_loop, this);
+}
+
+RotatingFileSink::~RotatingFileSink() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        try {
+            write_buffer();
+        } catch (...) {
+            // Nothing sensible to do with a write error during destruction
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(helper_mutex_);
+        stop_ = true;
+    }
+    helper_cv_.notify_one();
+    helper_.join();
+}
+
+void RotatingFileSink::write(std::string_view message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(message);
+}
+
+void RotatingFileSink::write_batch(std::span<const std::string_view> messages) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::string_view message : messages) {
+        append(message);
+    }
+}
+
+void RotatingFileSink::append(std::string_view message) {
+    if (rotation_due(message.size())) {
+        rotate();
+    }
+    file_size_ += message.size();
+
+    if (message.size() <= config_.buffer_size - buffer_used_) {
+        std::memcpy(buffer_.get() + buffer_used_, message.data(), message.size());
+        buffer_used_ += message.size();
+        if (buffer_used_ == config_.buffer_size) {
+            write_buffer();
+        }
+        return;
+    }
+
+    if (message.size() >= config_.buffer_size) {
+        // Too big to buffer: one writev() for the pending bytes and the message
+        std::string_view pending(buffer_.get(), buffer_used_);
+        buffer_used_ = 0;
+        writer_.write(pending, message);
+        return;
+    }
+
+    write_buffer();
+    std::memcpy(buffer_.get(), message.data(), message.size());
+    buffer_used_ = message.size();
+}
+
+void RotatingFileSink::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_buffer();
+}
+
+void RotatingFileSink::on_batch_end() {
+    flush();
+}
+
+std::string RotatingFileSink::rotated_filename(std::size_t index) const {
+    if (index == 0) {
+        return filename_;
+    }
+    std::filesystem::path path(filename_);
+    std::filesystem::path rotated = path.parent_path() /
+        (path.stem().string() + "." + std::to_string(index) + path.extension().string());
+    return rotated.string();
+}
+
+std::uint64_t RotatingFileSink::rotation_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rotations_;
+}
+
+bool RotatingFileSink::rotation_due(std::size_t incoming) {
+    if (config_.max_size > 0 && file_size_ > 0 && file_size_ + incoming > config_.max_size) {
+        return true;
+    }
+    return next_rotation_ != std::chrono::system_clock::time_point::max() &&
+           std::chrono::system_clock::now() >= next_rotation_;
+}
+
+void RotatingFileSink::rotate() {
+    if (!spare_ready_.load(std::memory_order_acquire)) {
+        // Helper still busy (or the last open failed): keep writing here.
+        // Ask once; later messages only recheck the flag until it is ready.
+        if (!rotation_deferred_ || spare_failed_.exchange(false, std::memory_order_relaxed)) {
+            {
+                std::lock_guard<std::mutex> lock(helper_mutex_);
+                spare_wanted_ = true;
+            }
+            helper_cv_.notify_one();
+        }
+        rotation_deferred_ = true;
+        return;
+    }
+    rotation_deferred_ = false;
+
+    // Buffered bytes belong to the file being rotated out. Only this side
+    // consumes the spare, so it stays ready while the lock is dropped.
+    write_buffer();
+
+    {
+        std::lock_guard<std::mutex> lock(helper_mutex_);
+        std::swap(writer_, spare_);
+        retired_ = std::move(spare_);
+        rotated_slot_ = spare_slot_;
+        spare_ready_.store(false, std::memory_order_relaxed);
+        rename_pending_ = true;
+    }
+    helper_cv_.notify_one();
+
+    file_size_ = 0;
+    ++rotations_;
+    schedule_next_rotation(std::chrono::system_clock::now());
+}
+
+void RotatingFileSink::write_buffer() {
+    if (buffer_used_ == 0) {
+        return;
+    }
+    // Drop the data even if the write throws, so one failure does not
+    // wedge every later message behind a full buffer
+    std::string_view pending(buffer_.get(), buffer_used_);
+    buffer_used_ = 0;
+    writer_.write(pending);
+}
+
+void RotatingFileSink::schedule_next_rotation(std::chrono::system_clock::time_point now) {
+    if (config_.interval.count() <= 0) {
+        return;
+    }
+    auto since_epoch = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch());
+    auto boundary = (since_epoch / config_.interval + 1) * config_.interval;
+    next_rotation_ = std::chrono::system_clock::time_point(boundary);
+}
+
+void RotatingFileSink::helper_loop() {
+    std::unique_lock<std::mutex> lock(helper_mutex_);
+    while (true) {
+        helper_cv_.wait(lock, [this] { return stop_ || rename_pending_ || spare_wanted_; });
+
+        if (rename_pending_) {
+            FileWriter retired = std::move(retired_);
+            writer_slot_ = rotated_slot_;
+            rename_pending_ = false;
+            bool stopping = stop_;
+            lock.unlock();
+            retired.close();
+            // The other temporary name was moved to `filename` by the
+            // previous shift, so the next spare can open before we wait
+            // for the compressor; the writer can rotate again meanwhile
+            if (!stopping) {
+                prepare_spare(writer_slot_ ^ 1);
+            }
+            if (compressing_.valid()) {
+                compressing_.wait();  // Do not rename a file being compressed
+            }
+            shift_rotated_files(writer_slot_);
+            // Compression is skipped during shutdown: the backend may
+            // already be gone
+            if (config_.compression != Compression::None && !stopping) {
+                compressing_ = AsyncBackend::instance().compressor().submit(
+                    rotated_filename(1), config_.compression);
+            }
+            lock.lock();
+            continue;  // Renames first: another rotation may be pending
+        }
+
+        if (stop_) {
+            break;
+        }
+
+        if (spare_wanted_ && !spare_ready_.load(std::memory_order_relaxed)) {
+            spare_wanted_ = false;
+            lock.unlock();
+            prepare_spare(writer_slot_ ^ 1);
+            lock.lock();
+        }
+        spare_wanted_ = false;
+    }
+
+    // The spare was never written to
+    if (spare_ready_.load(std::memory_order_relaxed)) {
+        spare_.close();
+        spare_ready_.store(false, std::memory_order_relaxed);
+        std::error_code ec;
+        std::filesystem::remove(spare_filename(spare_slot_), ec);
+    }
+}
+
+void RotatingFileSink::prepare_spare(std::size_t slot) {
+    FileWriter spare;
+    try {
+        spare.open(spare_filename(slot), false);
+    } catch (...) {
+        // Retried at the next rotation attempt
+        spare_failed_.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(helper_mutex_);
+    spare_ = std::move(spare);
+    spare_slot_ = slot;
+    spare_ready_.store(true, std::memory_order_release);
+}
+
+std::string RotatingFileSink::spare_filename(std::size_t slot) const {
+    return filename_ + (slot == 0 ? ".next" : ".next2");
+}
+
+void RotatingFileSink::shift_rotated_files(std::size_t active_slot) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    std::string extension(compression_extension(config_.compression));
+
+    // A rotated file may be plain or compressed (compression can fail)
+    auto exists = [&](std::size_t index) {
+        return fs::exists(rotated_filename(index), ec) ||
+               (!extension.empty() && fs::exists(rotated_filename(index) + extension, ec));
+    };
+    auto move = [&](std::size_t from, std::size_t to) {
+        fs::rename(rotated_filename(from), rotated_filename(to), ec);
+        if (!extension.empty()) {
+            fs::rename(rotated_filename(from) + extension, rotated_filename(to) + extension, ec);
+        }
+    };
+
+    std::size_t last = 0;
+    if (config_.max_files > 0) {
+        fs::remove(rotated_filename(config_.max_files), ec);
+        if (!extension.empty()) {
+            fs::remove(rotated_filename(config_.max_files) + extension, ec);
+        }
+        last = config_.max_files - 1;
+    } else {
+        while (exists(last + 1)) {
+            ++last;
+        }
+    }
+
+    for (std::size_t index = last; index >= 1; --index) {
+        move(index, index + 1);
+    }
+    // The active file has been writing to the spare name since the swap
+    fs::rename(filename_, rotated_filename(1), ec);
+    fs::rename(spare_filename(active_slot), filename_, ec);
+}
+
+}  // namespace CoLog
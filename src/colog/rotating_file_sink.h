@@ -0,0 +1,126 @@
+#ifndef COLOG_ROTATING_FILE_SINK_H
+#define COLOG_ROTATING_FILE_SINK_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+
+#include "compression.h"
+#include "file_writer.h"
+#include "sink.h"
+
+namespace CoLog {
+
+struct RotationConfig {
+    std::uint64_t max_size = 0;         // Rotate once the file would exceed this many bytes (0 = never)
+    std::chrono::seconds interval{0};   // Rotate on multiples of this wall-clock interval, UTC (0 = never)
+    std::size_t max_files = 0;          // Rotated files to keep, oldest deleted first (0 = keep all)
+    std::size_t buffer_size = 64 * 1024;
+    Compression compression = Compression::None;  // Codec for rotated files
+};
+
+// File sink that rotates by size and/or wall-clock interval without
+// stalling the thread that writes.
+//
+// Writes always go to `filename`. Rotated files are named with an index
+// before the extension, newest first: app.log -> app.1.log, app.2.log...
+//
+// A helper thread keeps the next file open ahead of time under a
+// temporary name (`filename` + ".next", or ".next2" on alternate
+// rotations). At the rotation boundary the writer only swaps file
+// descriptors; the helper then closes the old descriptor, opens the next
+// spare under the other temporary name, renames the old file into the
+// rotated sequence, moves the new one to `filename` and deletes files
+// beyond `max_files`. Nothing is copied or truncated, so no lines are lost.
+//
+// With compression enabled each rotated file is handed to the
+// AsyncBackend's FileCompressor (app.1.log -> app.1.log.lz4). Files are
+// only shifted once the previous one has been compressed, so a compressor
+// that falls behind delays renaming rather than the writer: the spare is
+// already open, so the next rotation can still happen.
+// If the helper has fallen behind, writing continues into the current
+// file until the spare is ready; the writer then only checks an atomic
+// flag per message.
+//
+// Output is buffered as in BufferedFileSink and written at the end of each
+// async backend batch, on flush(), on rotation and on destruction.
+//
+// Relies on renaming files that are still open, which Windows does not
+// allow for descriptors opened by FileWriter.
+class RotatingFileSink : public ISink {
+public:
+    RotatingFileSink(const std::string& filename, RotationConfig config, bool append = true);
+    ~RotatingFileSink() override;
+
+    // Non-copyable
+    RotatingFileSink(const RotatingFileSink&) = delete;
+    RotatingFileSink& operator=(const RotatingFileSink&) = delete;
+
+    void write(std::string_view message) override;
+    void write_batch(std::span<const std::string_view> messages) override;
+    void flush() override;
+    void on_batch_end() override;
+
+    // Name of the index-th rotated file (index 0 is the active file)
+    std::string rotated_filename(std::size_t index) const;
+
+    // Completed rotations since construction
+    std::uint64_t rotation_count() const;
+
+private:
+    // write() without the lock; the caller holds mutex_
+    void append(std::string_view message);
+
+    bool rotation_due(std::size_t incoming);
+    void rotate();
+    void write_buffer();
+    void schedule_next_rotation(std::chrono::system_clock::time_point now);
+
+    void helper_loop();
+    void prepare_spare(std::size_t slot);
+    void shift_rotated_files(std::size_t active_slot);
+
+    // Temporary name of the spare in `slot` (0 or 1)
+    std::string spare_filename(std::size_t slot) const;
+
+    std::string filename_;
+    RotationConfig config_;
+
+    // Writer side, guarded by mutex_
+    FileWriter writer_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t buffer_used_ = 0;
+    std::uint64_t file_size_ = 0;  // Bytes in the active file, buffered ones included
+    std::chrono::system_clock::time_point next_rotation_ = std::chrono::system_clock::time_point::max();
+    std::uint64_t rotations_ = 0;
+    bool rotation_deferred_ = false;  // Due, but waiting for the spare
+    mutable std::mutex mutex_;
+
+    // Hand-off to the helper, guarded by helper_mutex_
+    // (spare_ready_ and spare_failed_ are also read by the writer without it)
+    FileWriter spare_;          // Open and ready when spare_ready_ is set
+    FileWriter retired_;        // Previous active file, waiting to be renamed and closed
+    std::size_t spare_slot_ = 0;    // Name of the spare
+    std::size_t rotated_slot_ = 0;  // Name of the active file after the pending rename
+    std::atomic<bool> spare_ready_{false};
+    std::atomic<bool> spare_failed_{false};  // Last open failed; ask again
+    bool rename_pending_ = false;
+    bool spare_wanted_ = true;  // Ask the helper to (re)open the spare
+    bool stop_ = false;
+    std::size_t writer_slot_ = 1;  // Helper only: name the active file had as a spare
+    std::mutex helper_mutex_;
+    std::condition_variable helper_cv_;
+    std::future<bool> compressing_;  // Helper thread only
+    std::thread helper_;
+};
+
+}  // namespace CoLog
+
+#endif  // COLOG_ROTATING_FILE_SINK_H
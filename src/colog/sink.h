@@ -1,9 +1,14 @@
 #ifndef COLOG_SINK_H
 #define COLOG_SINK_H
 
+#include <chrono>
+#include <cstddef>
 #include <memory>
+#include <span>
 #include <string_view>
 
+#include "record.h"
+
 namespace CoLog {
 
 class ISink {
@@ -11,6 +16,48 @@ public:
     virtual ~ISink() = default;
     virtual void write(std::string_view message) = 0;
     virtual void flush() = 0;
+
+    // Write several messages, in order, as if by write() on each. The
+    // async backend hands each sink its share of a batch through this, so
+    // sinks can take their lock once and make one system call. The
+    // default calls write() per message; if one throws, the rest of the
+    // batch is skipped.
+    virtual void write_batch(std::span<const std::string_view> messages) {
+        for (std::string_view message : messages) {
+            write(message);
+        }
+    }
+
+    // Sinks that encode records themselves (BinaryFileSink) return true.
+    // Loggers then hand them each record through write_record() instead
+    // of the formatter's text, so any per-stream state is built under the
+    // sink's lock, in the order records are written.
+    virtual bool writes_records() const { return false; }
+
+    // Write one record; called instead of write() when writes_records()
+    // is true. Views in `record` are only valid for the call, and
+    // `message` may be empty when `format` is set.
+    virtual void write_record(const LogRecord& record) { (void)record; }
+
+    // Called by the async backend after each batch of records written to
+    // this sink. Buffering sinks can hand their data to the OS here; the
+    // default does nothing.
+    virtual void on_batch_end() {}
+
+    // Sinks that hold data until it is old enough (CompressedFileSink)
+    // return when on_batch_end() should next run even if no batch comes;
+    // an idle async backend worker wakes up then to call it. The default
+    // time_point{} means nothing is waiting.
+    virtual std::chrono::steady_clock::time_point batch_end_deadline() const { return {}; }
+
+    // True if write()ing `bytes` right now would have to wait for earlier
+    // output to complete. The async backend then queues the sink's records
+    // and retries later instead of stalling its other sinks. Only called
+    // from the backend worker that owns the sink; the default never blocks.
+    virtual bool would_block(std::size_t bytes) {
+        (void)bytes;
+        return false;
+    }
 };
 
 using SinkPtr = std::shared_ptr<ISink>;
@@ -18,4 +65,3 @@ using SinkPtr = std::shared_ptr<ISink>;
 }  // namespace CoLog
 
 #endif  // COLOG_SINK_H
-
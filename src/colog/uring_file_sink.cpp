@@ -0,0 +1,456 @@
+#include "uring_file_sink.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define COLOG_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace CoLog {
+
+namespace detail {
+
+#ifdef COLOG_HAS_IO_URING
+
+/**
+ * @brief Minimal io_uring instance driven through the raw syscalls.
+ *
+ * Only what the sink needs: queue writes, submit (optionally waiting for
+ * completions) and reap completions. Not thread-safe; the sink's mutex
+ * serializes all access.
+ */
+class IoUring {
+public:
+    /**
+     * @brief Set up a ring and register @p count buffers of @p size bytes.
+     * @return nullptr if io_uring is not available.
+     */
+    static std::unique_ptr<IoUring> create(unsigned entries, char* buffers, std::size_t size,
+                                           std::size_t count) {
+        std::unique_ptr<IoUring> ring(new IoUring());
+        if (!ring->setup(entries)) {
+            return nullptr;
+        }
+
+        // Fixed buffers save the kernel a page walk per write; without them
+        // (e.g. RLIMIT_MEMLOCK too low) plain writes still run async
+        std::vector<iovec> iovs(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            iovs[i] = {buffers + i * size, size};
+        }
+        ring->fixed_ = ::syscall(__NR_io_uring_register, ring->fd_, IORING_REGISTER_BUFFERS,
+                                 iovs.data(), static_cast<unsigned>(count)) == 0;
+        return ring;
+    }
+
+    ~IoUring() {
+        if (sqes_ != nullptr) {
+            ::munmap(sqes_, sqes_size_);
+        }
+        if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+            ::munmap(cq_ptr_, cq_size_);
+        }
+        if (sq_ptr_ != nullptr) {
+            ::munmap(sq_ptr_, sq_size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    /**
+     * @brief Queue a write; false if the submission queue is full.
+     */
+    bool push_write(int fd, std::uint32_t buffer, const char* data, std::uint32_t length,
+                    std::uint64_t offset, std::uint64_t user_data) {
+        unsigned tail = *sq_tail_;
+        unsigned head = std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire);
+        if (tail - head >= sq_entries_) {
+            return false;
+        }
+
+        unsigned index = tail & *sq_mask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = fixed_ ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<std::uint64_t>(data);
+        sqe->len = length;
+        sqe->off = offset;
+        sqe->buf_index = static_cast<std::uint16_t>(buffer);
+        sqe->user_data = user_data;
+        sq_array_[index] = index;
+
+        std::atomic_ref<unsigned>(*sq_tail_).store(tail + 1, std::memory_order_release);
+        ++to_submit_;
+        return true;
+    }
+
+    /**
+     * @brief Submit queued writes and wait for @p wait_nr completions.
+     * @return 0 or a negative errno.
+     */
+    int submit(unsigned wait_nr) {
+        while (true) {
+            unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+            long ret = ::syscall(__NR_io_uring_enter, fd_, to_submit_, wait_nr, flags,
+                                 nullptr, 0);
+            if (ret >= 0) {
+                to_submit_ -= std::min<unsigned>(to_submit_, static_cast<unsigned>(ret));
+                return 0;
+            }
+            if (errno != EINTR) {
+                return -errno;
+            }
+        }
+    }
+
+    /**
+     * @brief Call @p handle(user_data, result) for every available completion.
+     */
+    template <typename Handler>
+    void reap(Handler&& handle) {
+        unsigned head = *cq_head_;
+        unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+        while (head != tail) {
+            const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+            std::uint64_t user_data = cqe.user_data;
+            int result = cqe.res;
+            ++head;
+            std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+            handle(user_data, result);
+        }
+    }
+
+private:
+    IoUring() = default;
+
+    bool setup(unsigned entries) {
+        io_uring_params params{};
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) {
+            return false;
+        }
+
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+        }
+
+        sq_ptr_ = map(sq_size_, IORING_OFF_SQ_RING);
+        if (sq_ptr_ == nullptr) {
+            return false;
+        }
+        cq_ptr_ = single_mmap ? sq_ptr_ : map(cq_size_, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == nullptr) {
+            return false;
+        }
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+        if (sqes_ == nullptr) {
+            return false;
+        }
+
+        auto* sq = static_cast<char*>(sq_ptr_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sq_entries_ = params.sq_entries;
+
+        auto* cq = static_cast<char*>(cq_ptr_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    void* map(std::size_t size, std::uint64_t offset) {
+        void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           fd_, static_cast<off_t>(offset));
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    int fd_ = -1;
+    bool fixed_ = false;
+    unsigned to_submit_ = 0;
+
+    void* sq_ptr_ = nullptr;
+    void* cq_ptr_ = nullptr;
+    std::size_t sq_size_ = 0;
+    std::size_t cq_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    std::size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_mask_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_entries_ = 0;
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned* cq_mask_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+#else
+
+// No io_uring on this platform: the sink always uses pwrite()
+class IoUring {
+public:
+    static std::unique_ptr<IoUring> create(unsigned, char*, std::size_t, std::size_t) {
+        return nullptr;
+    }
+
+    bool push_write(int, std::uint32_t, const char*, std::uint32_t, std::uint64_t,
+                    std::uint64_t) {
+        return false;
+    }
+    int submit(unsigned) { return -ENOSYS; }
+    template <typename Handler>
+    void reap(Handler&&) {}
+};
+
+#endif
+
+}  // namespace detail
+
+namespace {
+
+[[noreturn]] void throw_errno(const std::string& what, const std::string& filename,
+                              int error) {
+    throw std::runtime_error(what + " " + filename + ": " + std::strerror(error));
+}
+
+}  // namespace
+
+UringFileSink::UringFileSink(const std::string& filename, bool append,
+                             std::size_t buffer_size, std::size_t buffer_count)
+    : filename_(filename),
+      buffer_size_(std::max<std::size_t>(buffer_size, 4096)),
+      buffer_count_(std::max<std::size_t>(buffer_count, 2)),
+      buffers_(new char[buffer_size_ * buffer_count_]),
+      in_flight_(buffer_count_) {
+    // No O_APPEND: writes carry explicit offsets and may complete out of order
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? 0 : O_TRUNC);
+    fd_ = ::open(filename.c_str(), flags, 0644);
+    if (fd_ < 0) {
+        throw_errno("Failed to open log file", filename, errno);
+    }
+    off_t end = append ? ::lseek(fd_, 0, SEEK_END) : 0;
+    file_offset_ = end > 0 ? static_cast<std::uint64_t>(end) : 0;
+
+    free_.reserve(buffer_count_);
+    for (std::size_t i = buffer_count_; i-- > 0;) {
+        free_.push_back(static_cast<std::uint32_t>(i));
+    }
+
+    ring_ = detail::IoUring::create(static_cast<unsigned>(buffer_count_ * 2), buffers_.get(),
+                                    buffer_size_, buffer_count_);
+}
+
+UringFileSink::~UringFileSink() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    try {
+        submit_current();
+        wait_all();
+    } catch (...) {
+        // Nothing sensible to do with a write error during destruction
+    }
+    // Tear the ring down while the registered buffers are still alive
+    ring_.reset();
+    ::close(fd_);
+}
+
+void UringFileSink::write(std::string_view message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(message);
+}
+
+void UringFileSink::write_batch(std::span<const std::string_view> messages) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::string_view message : messages) {
+        append(message);
+    }
+}
+
+void UringFileSink::append(std::string_view message) {
+    while (!message.empty()) {
+        if (current_ == kNoBuffer) {
+            acquire_buffer();
+        }
+        std::size_t n = std::min(message.size(), buffer_size_ - current_size_);
+        std::memcpy(buffer_data(current_) + current_size_, message.data(), n);
+        current_size_ += n;
+        message.remove_prefix(n);
+        if (current_size_ == buffer_size_) {
+            submit_current();
+        }
+    }
+}
+
+void UringFileSink::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    submit_current();
+    wait_all();
+}
+
+void UringFileSink::on_batch_end() {
+    // Hand the partial buffer to the kernel but do not wait for it
+    std::lock_guard<std::mutex> lock(mutex_);
+    submit_current();
+    reap(false);
+}
+
+bool UringFileSink::would_block(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t room = current_ != kNoBuffer ? buffer_size_ - current_size_ : 0;
+    if (bytes <= room || ring_ == nullptr) {
+        return false;
+    }
+
+    // Every further buffer the message spills into must already be free
+    reap(false);
+    std::size_t needed = (bytes - room + buffer_size_ - 1) / buffer_size_;
+    return free_.size() < needed;
+}
+
+bool UringFileSink::uses_io_uring() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ring_ != nullptr;
+}
+
+void UringFileSink::submit_current() {
+    if (current_ == kNoBuffer || current_size_ == 0) {
+        return;
+    }
+
+    std::uint32_t index = current_;
+    in_flight_[index] = {file_offset_, static_cast<std::uint32_t>(current_size_), 0};
+    file_offset_ += current_size_;
+    current_ = kNoBuffer;
+    current_size_ = 0;
+    ++in_flight_count_;
+
+    if (ring_ == nullptr) {
+        write_sync(index);
+        return;
+    }
+    submit_write(index);
+    int result = ring_->submit(0);
+    if (result < 0 && result != -EAGAIN && result != -EBUSY) {
+        throw_errno("io_uring submit failed for", filename_, -result);
+    }
+}
+
+void UringFileSink::submit_write(std::uint32_t index) {
+    const InFlight& write = in_flight_[index];
+    while (!ring_->push_write(fd_, index, buffer_data(index) + write.done,
+                              write.length - write.done, write.offset + write.done, index)) {
+        // Cannot happen with 2 entries per buffer, but never drop data
+        reap(true);
+    }
+}
+
+void UringFileSink::write_sync(std::uint32_t index) {
+    InFlight& write = in_flight_[index];
+    int error = 0;
+    while (write.done < write.length) {
+        auto written = ::pwrite(fd_, buffer_data(index) + write.done, write.length - write.done,
+                                static_cast<off_t>(write.offset + write.done));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = errno;
+            break;
+        }
+        write.done += static_cast<std::uint32_t>(written);
+    }
+
+    // Recycle the buffer even on failure so later messages are not blocked
+    --in_flight_count_;
+    free_.push_back(index);
+    if (error != 0) {
+        throw_errno("Failed to write log file", filename_, error);
+    }
+}
+
+void UringFileSink::acquire_buffer() {
+    reap(false);
+    while (free_.empty()) {
+        reap(true);
+    }
+    current_ = free_.back();
+    free_.pop_back();
+}
+
+void UringFileSink::reap(bool wait) {
+    if (ring_ == nullptr) {
+        return;
+    }
+    if (wait) {
+        int result = ring_->submit(1);
+        if (result < 0 && result != -EAGAIN && result != -EBUSY) {
+            throw_errno("io_uring wait failed for", filename_, -result);
+        }
+    }
+
+    bool resubmit = false;
+    std::vector<std::uint32_t> failed;
+    ring_->reap([&](std::uint64_t user_data, int result) {
+        auto index = static_cast<std::uint32_t>(user_data);
+        InFlight& write = in_flight_[index];
+        if (result == -EAGAIN || result == -EINTR) {
+            submit_write(index);
+            resubmit = true;
+        } else if (result <= 0) {
+            failed.push_back(index);  // Retry synchronously below
+        } else if ((write.done += static_cast<std::uint32_t>(result)) < write.length) {
+            submit_write(index);      // Short write: queue the remainder
+            resubmit = true;
+        } else {
+            --in_flight_count_;
+            free_.push_back(index);
+        }
+    });
+
+    if (resubmit) {
+        ring_->submit(0);
+    }
+    std::exception_ptr error;
+    for (std::uint32_t index : failed) {
+        try {
+            write_sync(index);
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void UringFileSink::wait_all() {
+    while (in_flight_count_ > 0) {
+        reap(true);
+    }
+}
+
+}  // namespace CoLog
@@ -0,0 +1,101 @@
+#ifndef COLOG_URING_FILE_SINK_H
+#define COLOG_URING_FILE_SINK_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "sink.h"
+
+namespace CoLog {
+
+namespace detail {
+class IoUring;
+}  // namespace detail
+
+// File sink that writes through io_uring on Linux, so a slow disk does not
+// stall the thread producing log lines.
+//
+// Messages are copied into one of `buffer_count` fixed buffers that are
+// registered with the kernel. A full buffer (or the pending one at the end
+// of an async backend batch) is submitted as a WRITE_FIXED at an explicit
+// file offset and the sink moves on to the next free buffer; buffers are
+// recycled as their completions arrive. Only when every buffer is in
+// flight does write() wait. flush() waits for all outstanding writes.
+// would_block() reports that case, so the async backend can service its
+// other sinks while this one's writes complete.
+//
+// If io_uring is unavailable (old kernel, seccomp, non-Linux) the sink
+// falls back to synchronous pwrite() of the same buffers.
+//
+// Offsets are tracked by the sink, so the file must not be appended to by
+// anyone else while it is open.
+class UringFileSink : public ISink {
+public:
+    static constexpr std::size_t kDefaultBufferSize = 256 * 1024;
+    static constexpr std::size_t kDefaultBufferCount = 8;
+
+    explicit UringFileSink(const std::string& filename, bool append = true,
+                           std::size_t buffer_size = kDefaultBufferSize,
+                           std::size_t buffer_count = kDefaultBufferCount);
+    ~UringFileSink() override;
+
+    // Non-copyable
+    UringFileSink(const UringFileSink&) = delete;
+    UringFileSink& operator=(const UringFileSink&) = delete;
+
+    void write(std::string_view message) override;
+    void write_batch(std::span<const std::string_view> messages) override;
+    void flush() override;
+    void on_batch_end() override;
+    bool would_block(std::size_t bytes) override;
+
+    // False when running on the pwrite() fallback
+    bool uses_io_uring() const;
+
+private:
+    // write() without the lock; the caller holds mutex_
+    void append(std::string_view message);
+
+    static constexpr std::uint32_t kNoBuffer = static_cast<std::uint32_t>(-1);
+
+    // A buffer handed to the kernel and not yet fully written
+    struct InFlight {
+        std::uint64_t offset = 0;
+        std::uint32_t length = 0;
+        std::uint32_t done = 0;
+    };
+
+    char* buffer_data(std::uint32_t index) { return buffers_.get() + index * buffer_size_; }
+
+    void submit_current();
+    void submit_write(std::uint32_t index);
+    void write_sync(std::uint32_t index);
+    void acquire_buffer();
+    void reap(bool wait);
+    void wait_all();
+
+    int fd_ = -1;
+    std::string filename_;
+    std::unique_ptr<detail::IoUring> ring_;  // Null on the fallback path
+
+    std::size_t buffer_size_;
+    std::size_t buffer_count_;
+    std::unique_ptr<char[]> buffers_;
+    std::vector<std::uint32_t> free_;
+    std::vector<InFlight> in_flight_;
+    std::size_t in_flight_count_ = 0;
+
+    std::uint32_t current_ = kNoBuffer;
+    std::size_t current_size_ = 0;
+    std::uint64_t file_offset_ = 0;
+
+    mutable std::mutex mutex_;
+};
+
+}  // namespace CoLog
+
+#endif  // COLOG_URING_FILE_SINK_H
@@ -36,7 +36,7 @@ void demo_async_logger() {
 
     // Initialize the async backend
     CoLog::AsyncConfig config;
-    config.queue_size = 8192;
+    config.queue_bytes = 1 << 20;
     config.batch_size = 256;
     config.flush_interval = std::chrono::milliseconds(100);
     CoLog::init_async(config);
@@ -57,6 +57,9 @@ void demo_async_logger() {
     // Demonstrate non-blocking nature
     logger->info("This returns immediately - I/O happens in background!");
 
+    // Deferred formatting: arguments are formatted on the backend thread
+    logger->info("Request {} took {}us ({:.1f}% of budget)", 42, 1375, 13.75);
+
     // Wait for all messages to be processed
     logger->flush_wait();
 }
@@ -73,7 +76,7 @@ void demo_async_throughput() {
     auto start = std::chrono::high_resolution_clock::now();
 
     for (int i = 0; i < NUM_MESSAGES; ++i) {
-        logger->info("Benchmark message number " + std::to_string(i));
+        logger->info("Benchmark message number {}", i);
     }
 
     auto enqueue_time = std::chrono::high_resolution_clock::now();
@@ -0,0 +1,105 @@
+// A log_async() call suspended on a full ring must finish, dropping its
+// record, when it is resumed after shutdown_async().
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "colog/async/scheduler.h"
+#include "colog/async_logger.h"
+
+namespace {
+
+// Blocks the worker in write() until opened
+class GateSink : public CoLog::ISink {
+public:
+    void write(std::string_view /*message*/) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        entered_ = true;
+        cv_.notify_all();
+        cv_.wait(lock, [this] { return open_; });
+    }
+    void flush() override {}
+
+    void wait_entered() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return entered_; });
+    }
+    void open() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool entered_ = false;
+    bool open_ = false;
+};
+
+std::mutex g_posted_mutex;
+std::vector<std::coroutine_handle<>> g_posted;
+
+CoLog::detail::Task log_once(CoLog::AsyncLogger& logger, std::atomic<bool>& finished) {
+    co_await logger.info_async("suspended {}", 1);
+    finished = true;
+}
+
+int fail(const char* what) {
+    std::fprintf(stderr, "FAIL: %s\n", what);
+    return 1;
+}
+
+}  // namespace
+
+int main() {
+    CoLog::AsyncConfig config;
+    config.queue_bytes = 4096;
+    config.overflow_policy = CoLog::OverflowPolicy::Discard;
+    config.resume_waiter = [](std::coroutine_handle<> handle) {
+        std::lock_guard<std::mutex> lock(g_posted_mutex);
+        g_posted.push_back(handle);
+    };
+    CoLog::init_async(config);
+
+    auto sink = std::make_shared<GateSink>();
+    auto logger = std::make_shared<CoLog::AsyncLogger>("shutdown");
+    logger->add_sink(sink);
+
+    // Park the worker in the sink, then fill the ring behind it
+    logger->info("first");
+    sink->wait_entered();
+    for (int i = 0; i < 1000; ++i) {
+        logger->info("filler message to fill the ring while the worker is blocked");
+    }
+
+    std::atomic<bool> finished{false};
+    CoLog::detail::Task task = log_once(*logger, finished);
+    task.handle().resume();
+    if (task.done()) {
+        return fail("log_async did not suspend on a full ring");
+    }
+
+    sink->open();
+    CoLog::shutdown_async();
+
+    // Run what the executor would have run after shutdown
+    std::vector<std::coroutine_handle<>> posted;
+    {
+        std::lock_guard<std::mutex> lock(g_posted_mutex);
+        posted.swap(g_posted);
+    }
+    for (std::coroutine_handle<> handle : posted) {
+        handle.resume();
+    }
+
+    if (!finished || !task.done()) {
+        return fail("suspended log_async did not finish after shutdown");
+    }
+    std::puts("PASS");
+    return 0;
+}
@@ -0,0 +1,169 @@
+// BinaryEncoder output must decode back to the same records: fed whole or
+// byte by byte, with a second session appended, with a truncated final
+// record, and (when zlib is built in) through gzip.
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <source_location>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "colog/binary_format.h"
+#include "colog/compression.h"
+#include "colog/format.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct Expected {
+    std::chrono::system_clock::time_point timestamp;
+    CoLog::LogLevel level;
+    std::string logger;
+    std::uint64_t thread_id;
+    std::string message;
+    std::uint32_t line;
+};
+
+int fail(const char* what) {
+    std::fprintf(stderr, "FAIL: %s\n", what);
+    return 1;
+}
+
+// Encodes a session of records from two loggers and three call sites
+void encode_session(int count, std::chrono::system_clock::time_point start, std::string& out,
+                    std::vector<Expected>& expected) {
+    CoLog::BinaryEncoder encoder;
+    const char* format = "request {} took {} ms for {}";
+    for (int i = 0; i < count; ++i) {
+        std::string name = i % 2 == 0 ? "http" : "db";
+        auto timestamp = start + std::chrono::nanoseconds(i * 1500 - (i % 3) * 700);
+        auto level = static_cast<CoLog::LogLevel>(i % 6);
+        std::uint64_t thread_id = 100 + i % 4;
+
+        if (i % 3 == 0) {
+            // Deferred formatting: format string and encoded arguments
+            std::string user = "user" + std::to_string(i);
+            std::size_t size = CoLog::encoded_args_size(i, 0.25 * i, user);
+            std::vector<std::byte> args(size);
+            CoLog::encode_args(args.data(), i, 0.25 * i, user);
+
+            auto location = std::source_location::current();
+            CoLog::LogRecord record(timestamp, level, {}, name, location, thread_id);
+            record.format = format;
+            record.format_args = args;
+            encoder.encode(record, out);
+            expected.push_back({timestamp, level, name, thread_id,
+                                CoLog::format(format, i, 0.25 * i, user), location.line()});
+        } else {
+            // Preformatted message, from a different call site
+            std::string message = "message " + std::to_string(i) + (i % 3 == 1 ? "" : " {braces}");
+            auto location = i % 3 == 1 ? std::source_location::current()
+                                       : std::source_location::current();
+            CoLog::LogRecord record(timestamp, level, message, name, location, thread_id);
+            encoder.encode(record, out);
+            expected.push_back({timestamp, level, name, thread_id, message, location.line()});
+        }
+    }
+}
+
+// Decodes `data` in chunks of `chunk` bytes
+std::vector<Expected> decode(std::string_view data, std::size_t chunk,
+                             CoLog::BinaryLogDecoder& decoder) {
+    std::vector<Expected> records;
+    auto handler = [&records](const CoLog::BinaryRecord& record) {
+        std::string message;
+        CoLog::vformat_to(message, record.format, record.args);
+        records.push_back({record.timestamp, record.level, std::string(record.logger_name),
+                           record.thread_id, message, record.line});
+    };
+    for (std::size_t pos = 0; pos < data.size(); pos += chunk) {
+        decoder.feed(data.substr(pos, chunk), handler);
+    }
+    return records;
+}
+
+bool same(const std::vector<Expected>& decoded, const std::vector<Expected>& expected,
+          std::size_t count) {
+    if (decoded.size() != count) {
+        return false;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        const Expected& a = decoded[i];
+        const Expected& b = expected[i];
+        if (a.timestamp != b.timestamp || a.level != b.level || a.logger != b.logger ||
+            a.thread_id != b.thread_id || a.message != b.message || a.line != b.line) {
+            std::fprintf(stderr, "record %zu: \"%s\" != \"%s\"\n", i, a.message.c_str(),
+                         b.message.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    std::string encoded;
+    std::vector<Expected> expected;
+    auto now = std::chrono::system_clock::now();
+    encode_session(1000, now, encoded, expected);
+    // A second writer appending to the same file starts a new session,
+    // with timestamps that may go backwards
+    encode_session(500, now - std::chrono::seconds(5), encoded, expected);
+
+    {
+        CoLog::BinaryLogDecoder decoder;
+        if (!same(decode(encoded, encoded.size(), decoder), expected, expected.size()) ||
+            decoder.has_partial()) {
+            return fail("records fed in one piece did not round trip");
+        }
+    }
+    {
+        CoLog::BinaryLogDecoder decoder;
+        if (!same(decode(encoded, 1, decoder), expected, expected.size()) ||
+            decoder.has_partial()) {
+            return fail("records fed byte by byte did not round trip");
+        }
+    }
+    {
+        CoLog::BinaryLogDecoder decoder;
+        std::string_view torn(encoded.data(), encoded.size() - 3);
+        if (!same(decode(torn, 4096, decoder), expected, expected.size() - 1) ||
+            !decoder.has_partial()) {
+            return fail("truncated final record was not held back as partial");
+        }
+    }
+    try {
+        CoLog::BinaryLogDecoder decoder;
+        decode("not a binary log", 64, decoder);
+        return fail("input without a header was accepted");
+    } catch (const std::runtime_error&) {
+    }
+
+    // Rotated binary logs compressed by the backend, as colog-decode reads them
+    if (CoLog::compression_available(CoLog::Compression::Gzip)) {
+        fs::path dir = fs::temp_directory_path() / ("colog_binary_test_" + std::to_string(getpid()));
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        fs::path plain = dir / "app.clog";
+        fs::path gz = dir / "app.clog.gz";
+        std::ofstream(plain, std::ios::binary).write(encoded.data(),
+                                                     static_cast<std::streamsize>(encoded.size()));
+        CoLog::compress_file(plain.string(), gz.string(), CoLog::Compression::Gzip);
+        CoLog::compress_file(plain.string(), gz.string(), CoLog::Compression::Gzip, {}, true);
+
+        std::string inflated;
+        CoLog::decompress_gzip_file(gz.string(), [&](std::string_view data) { inflated += data; });
+        fs::remove_all(dir);
+        if (inflated != encoded + encoded) {
+            return fail("gzip file with two members did not inflate to its input");
+        }
+    }
+
+    std::puts("PASS");
+    return 0;
+}
@@ -0,0 +1,199 @@
+// Round trips through the built-in LZ4 encoder: raw blocks and frames,
+// CompressedFileSink output read back through its seek index, by scanning
+// a truncated copy, after appending, and (when the lz4 program is passed
+// as argv[1]) by the reference decoder.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "colog/compressed_file_sink.h"
+#include "colog/compression.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr int kLines = 200000;
+
+int fail(const char* what) {
+    std::fprintf(stderr, "FAIL: %s\n", what);
+    return 1;
+}
+
+std::string read_file(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+std::string make_line(int index) {
+    return "line " + std::to_string(index) + " of the compressed round trip test\n";
+}
+
+// Text that compresses poorly, to exercise long literal runs
+std::string noise(std::size_t size) {
+    std::string text(size, '\0');
+    std::uint32_t state = 12345;
+    for (char& c : text) {
+        state = state * 1103515245 + 12345;
+        c = static_cast<char>(state >> 24);
+    }
+    return text;
+}
+
+bool block_round_trips(const std::string& input) {
+    std::vector<char> compressed(CoLog::detail::lz4_block_bound(input.size()));
+    std::size_t size = CoLog::detail::lz4_compress_block(input.data(), input.size(),
+                                                         compressed.data());
+    std::string output(input.size() + 1, '\0');
+    output.resize(CoLog::detail::lz4_decompress_block(compressed.data(), size, output.data(),
+                                                      output.size()));
+    return output == input;
+}
+
+bool frame_round_trips(const std::string& input) {
+    std::vector<char> frame(CoLog::detail::lz4_frame_bound(input.size()));
+    std::size_t size = CoLog::detail::lz4_write_frame(input.data(), input.size(), frame.data());
+    auto header = CoLog::detail::lz4_parse_frame_header(frame.data(), size);
+    if (!header.valid || header.content_size != input.size()) {
+        return false;
+    }
+    bool uncompressed = false;
+    std::uint32_t block = CoLog::detail::lz4_block_size(frame.data() + header.header_size,
+                                                        &uncompressed);
+    const char* data = frame.data() + header.header_size + 4;
+    std::string output;
+    if (uncompressed) {
+        output.assign(data, block);
+    } else {
+        output.resize(input.size());
+        output.resize(CoLog::detail::lz4_decompress_block(data, block, output.data(),
+                                                          output.size()));
+    }
+    return output == input;
+}
+
+std::string read_all_blocks(CoLog::CompressedLogReader& reader) {
+    std::string text;
+    for (std::size_t i = 0; i < reader.blocks().size(); ++i) {
+        text += reader.read_block(i);
+    }
+    return text;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string repetitive;
+    for (int i = 0; i < 5000; ++i) {
+        repetitive += make_line(i % 7);
+    }
+    const std::string inputs[] = {"", "a", "abcdefghijklm", std::string(100000, 'x'),
+                                  repetitive, noise(100000)};
+    for (const std::string& input : inputs) {
+        if (!block_round_trips(input)) {
+            return fail("LZ4 block does not decompress to its input");
+        }
+        if (!frame_round_trips(input)) {
+            return fail("LZ4 frame does not decompress to its input");
+        }
+    }
+    try {
+        CoLog::detail::lz4_decompress_block("\xf0", 1, nullptr, 0);
+        return fail("corrupt LZ4 block was accepted");
+    } catch (const std::runtime_error&) {
+    }
+
+    fs::path dir = fs::temp_directory_path() / ("colog_compressed_test_" + std::to_string(getpid()));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::path path = dir / "app.log.lz4";
+
+    std::string expected;
+    {
+        CoLog::CompressedFileSink sink(path.string(), false, 64 * 1024);
+        for (int i = 0; i < kLines; ++i) {
+            std::string line = make_line(i);
+            sink.write(line);
+            expected += line;
+        }
+        if (sink.raw_bytes() != expected.size()) {
+            return fail("raw byte count does not match the input");
+        }
+    }
+
+    // Through the seek index
+    {
+        CoLog::CompressedLogReader reader(path.string());
+        if (!reader.indexed() || reader.blocks().size() < 2) {
+            return fail("closed file has no usable seek index");
+        }
+        if (read_all_blocks(reader) != expected) {
+            return fail("blocks read through the index differ from the input");
+        }
+
+        std::string target = make_line(kLines / 2);
+        std::uint64_t raw_offset = expected.find(target);
+        std::size_t index = reader.find_block(raw_offset);
+        const CoLog::CompressedBlock& block = reader.blocks().at(index);
+        if (reader.read_block(index).compare(raw_offset - block.raw_offset, target.size(),
+                                             target) != 0) {
+            return fail("find_block returned a block without the requested line");
+        }
+        if (reader.find_block(expected.size()) != reader.blocks().size()) {
+            return fail("find_block past the end did not return blocks().size()");
+        }
+    }
+
+    // A copy cut mid-block has no index: the scan keeps every whole block
+    {
+        std::string bytes = read_file(path);
+        fs::path torn = dir / "torn.log.lz4";
+        std::ofstream(torn, std::ios::binary).write(bytes.data(),
+                                                    static_cast<std::streamsize>(bytes.size() / 2));
+        CoLog::CompressedLogReader reader(torn.string());
+        std::string text = read_all_blocks(reader);
+        if (reader.indexed() || reader.blocks().empty() || text.size() >= expected.size() ||
+            expected.compare(0, text.size(), text) != 0) {
+            return fail("scan of a truncated file did not yield a prefix of the input");
+        }
+    }
+
+    // Appending drops the old index and writes a new one covering both sessions
+    {
+        CoLog::CompressedFileSink sink(path.string(), true, 64 * 1024);
+        std::string line = "appended line\n";
+        sink.write(line);
+        expected += line;
+    }
+    {
+        CoLog::CompressedLogReader reader(path.string());
+        if (!reader.indexed() || read_all_blocks(reader) != expected) {
+            return fail("appended file does not read back as both sessions");
+        }
+    }
+
+    // The reference decoder must read the whole file, index frame included
+    if (argc > 1) {
+        fs::path decoded = dir / "decoded.log";
+        std::string command = std::string("\"") + argv[1] + "\" -dcq \"" + path.string() +
+                              "\" > \"" + decoded.string() + "\"";
+        if (std::system(command.c_str()) != 0) {
+            return fail("lz4 could not decode the sink's output");
+        }
+        if (read_file(decoded) != expected) {
+            return fail("lz4 output differs from the input");
+        }
+    }
+
+    fs::remove_all(dir);
+    std::puts("PASS");
+    return 0;
+}
@@ -0,0 +1,207 @@
+// colog-decode: turn binary CoLog files (BinaryFileSink output) back into
+// text or JSON lines.
+//
+// Inputs may also be compressed: LZ4 files (CompressedFileSink output, or
+// rotated files compressed by the backend) are decompressed block by block
+// on the fly, and gzip files are inflated when the build has zlib.
+//
+//   colog-decode app.clog
+//   colog-decode --json app.clog.lz4 > app.jsonl
+//   colog-decode app.1.clog.gz
+//   colog-decode --pattern "%H:%M:%S.%f %L %v" app.clog
+
+#include "colog/binary_format.h"
+#include "colog/compressed_file_sink.h"
+#include "colog/compression.h"
+#include "colog/format.h"
+#include "colog/pattern_formatter.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    bool json = false;
+    std::string pattern{CoLog::PatternFormatter::kDefaultPattern};
+    std::string output;
+    std::vector<std::string> inputs;
+};
+
+void print_usage() {
+    std::cerr <<
+        "Usage: colog-decode [options] FILE...\n"
+        "  --json            One JSON object per record instead of text\n"
+        "  --pattern P       Text layout, PatternFormatter flags (default \"" <<
+        CoLog::PatternFormatter::kDefaultPattern << "\")\n"
+        "                    Source location flags are not available; use --json\n"
+        "  --output FILE     Write to FILE instead of stdout\n";
+}
+
+Options parse_options(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            std::exit(0);
+        }
+        if (arg == "--json") {
+            options.json = true;
+            continue;
+        }
+        if (arg == "--pattern" || arg == "--output") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            (arg == "--pattern" ? options.pattern : options.output) = argv[++i];
+            continue;
+        }
+        if (arg.size() > 1 && arg[0] == '-') {
+            throw std::invalid_argument("unknown option " + arg);
+        }
+        options.inputs.push_back(arg);
+    }
+    if (options.inputs.empty()) {
+        throw std::invalid_argument("no input files");
+    }
+    return options;
+}
+
+void append_json_string(std::string& out, std::string_view text) {
+    out.push_back('"');
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escape[8];
+                    std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+                    out += escape;
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+/**
+ * @brief Renders decoded records as text or JSON lines.
+ */
+class Printer {
+public:
+    Printer(const Options& options, std::ostream& out)
+        : json_(options.json), formatter_(options.pattern), out_(out) {}
+
+    void print(const CoLog::BinaryRecord& record) {
+        message_.clear();
+        CoLog::vformat_to(message_, record.format, record.args);
+        line_.clear();
+
+        if (json_) {
+            auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                record.timestamp.time_since_epoch()).count();
+            line_ += "{\"ts_ns\":" + std::to_string(nanos) + ",\"level\":";
+            append_json_string(line_, CoLog::to_string(record.level));
+            line_ += ",\"logger\":";
+            append_json_string(line_, record.logger_name);
+            line_ += ",\"thread\":" + std::to_string(record.thread_id) + ",\"file\":";
+            append_json_string(line_, record.file);
+            line_ += ",\"line\":" + std::to_string(record.line) + ",\"function\":";
+            append_json_string(line_, record.function);
+            line_ += ",\"message\":";
+            append_json_string(line_, message_);
+            line_ += "}\n";
+        } else {
+            CoLog::LogRecord text(record.timestamp, record.level, message_, record.logger_name,
+                                  std::source_location{}, record.thread_id);
+            formatter_.format_to(text, line_);
+        }
+        out_.write(line_.data(), static_cast<std::streamsize>(line_.size()));
+    }
+
+private:
+    bool json_;
+    CoLog::PatternFormatter formatter_;
+    std::ostream& out_;
+    std::string message_;
+    std::string line_;
+};
+
+bool starts_with_gzip_magic(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    unsigned char magic[2] = {};
+    in.read(reinterpret_cast<char*>(magic), sizeof(magic));
+    return in.gcount() == 2 && magic[0] == CoLog::detail::kGzipMagic[0] &&
+           magic[1] == CoLog::detail::kGzipMagic[1];
+}
+
+void decode_file(const std::string& path, Printer& printer) {
+    CoLog::BinaryLogDecoder decoder;
+    auto handler = [&printer](const CoLog::BinaryRecord& record) { printer.print(record); };
+
+    if (starts_with_gzip_magic(path)) {
+        CoLog::decompress_gzip_file(path, [&](std::string_view data) {
+            decoder.feed(data, handler);
+        });
+    } else if (CoLog::CompressedLogReader reader(path); reader.starts_with_frame()) {
+        for (std::size_t i = 0; i < reader.blocks().size(); ++i) {
+            decoder.feed(reader.read_block(i), handler);
+        }
+    } else {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> chunk(1 << 20);
+        while (in) {
+            in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            decoder.feed(std::string_view(chunk.data(), static_cast<std::size_t>(in.gcount())),
+                         handler);
+        }
+    }
+    if (decoder.has_partial()) {
+        std::cerr << "colog-decode: " << path << ": ignoring truncated final record\n";
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "colog-decode: " << e.what() << "\n";
+        print_usage();
+        return 2;
+    }
+
+    std::ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output, std::ios::binary);
+        if (!file) {
+            std::cerr << "colog-decode: cannot open " << options.output << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = options.output.empty() ? std::cout : file;
+    std::ios::sync_with_stdio(false);
+
+    Printer printer(options, out);
+    for (const auto& input : options.inputs) {
+        try {
+            decode_file(input, printer);
+        } catch (const std::exception& e) {
+            std::cerr << "colog-decode: " << input << ": " << e.what() << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}